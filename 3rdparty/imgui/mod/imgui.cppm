@@ -66,6 +66,7 @@ export {
     using ::ImGuiPopupFlags;
     using ::ImGuiSelectableFlags;
     using ::ImGuiSliderFlags;
+    using ::ImGuiSliderFlags_Logarithmic;
     using ::ImGuiTabBarFlags;
     using ::ImGuiTabItemFlags;
     using ::ImGuiTableFlags;
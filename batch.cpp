@@ -0,0 +1,310 @@
+// Solves paths without a window, for CI and render farms. Streams path definitions from text files
+// (or stdin) through solveBatch() on all cores, a chunk of paths at a time, and writes the
+// velocities, errors and, on request, progress samples and tessellated curves, in input order. The
+// memory in use is bounded by the chunk size, whatever the size of the input.
+//
+// The text formats are described in main.pathstream. Binary path files (see main.pathfile) are
+// recognized by their magic and mapped instead.
+
+import std;
+
+import main.pathfile;
+import main.pathstream;
+import main.solver;
+import main.workerpool;
+
+namespace {
+
+struct BatchOptions
+{
+    EaseInOut                       easeInOut           = EaseInOut::Sine;
+    SolverMode                      solverMode          = SolverMode::Direct;
+    float                           tolerance           = 1e-4f;    // fraction of the progress span
+    bool                            tessellate          = false;
+    size_t                          samples             = 0;
+    size_t                          chunk               = 1 << 20;  // checkpoints solved together
+    size_t                          threads             = WorkerPool::defaultThreadCount();
+    std::string                     output              = {};       // stdout when empty
+    std::string                     save                = {};       // binary path file, none when empty
+    std::vector<std::string>        inputs              = {};       // stdin when empty
+};
+
+void printUsage()
+{
+    std::println(std::cerr, "usage: easecurve-batch [options] [input...]");
+    std::println(std::cerr, "  --ease linear|sine      easing between velocities (sine)");
+    std::println(std::cerr, "  --iterative             use the iterative solver instead of the direct one");
+    std::println(std::cerr, "  --tessellate            also write the tessellated curves");
+    std::println(std::cerr, "  --tolerance <fraction>  tessellation tolerance, relative to the progress span (1e-4)");
+    std::println(std::cerr, "  --samples <count>       also write the progress at count evenly spaced times");
+    std::println(std::cerr, "  --chunk <checkpoints>   checkpoints read ahead and solved together (1048576)");
+    std::println(std::cerr, "  --threads <count>       worker threads, 0 solves on the calling thread");
+    std::println(std::cerr, "  --output <file>         write to a file instead of stdout");
+    std::println(std::cerr, "  --save <file>           also save the paths and their velocities as a binary path");
+    std::println(std::cerr, "                          file; this keeps all of them in memory");
+}
+
+template <typename T>
+bool parseValue(const std::string_view text, T& value)
+{
+    std::istringstream stream { std::string(text) };
+    return (stream >> value) && (stream >> std::ws).eof();
+}
+
+std::optional<BatchOptions> parseOptions(const std::span<char*> args)
+{
+    BatchOptions options;
+    for (size_t index = 1; index < args.size(); ++index) {
+        const std::string_view arg = args[index];
+        auto value = [&]() -> std::optional<std::string_view> {
+            if (index + 1 >= args.size()) {
+                std::println(std::cerr, "missing value for {}", arg);
+                return std::nullopt;
+            }
+            return args[++index];
+        };
+        if (arg == "--ease") {
+            const auto ease = value();
+            if (ease == "linear") {
+                options.easeInOut = EaseInOut::Linear;
+            } else if (ease == "sine") {
+                options.easeInOut = EaseInOut::Sine;
+            } else {
+                return std::nullopt;
+            }
+        } else if (arg == "--iterative") {
+            options.solverMode = SolverMode::Iterative;
+        } else if (arg == "--tessellate") {
+            options.tessellate = true;
+        } else if (arg == "--tolerance") {
+            const auto tolerance = value();
+            if (!tolerance || !parseValue(*tolerance, options.tolerance)) {
+                return std::nullopt;
+            }
+        } else if (arg == "--samples") {
+            const auto samples = value();
+            if (!samples || !parseValue(*samples, options.samples)) {
+                return std::nullopt;
+            }
+        } else if (arg == "--chunk") {
+            const auto chunk = value();
+            if (!chunk || !parseValue(*chunk, options.chunk) || options.chunk == 0) {
+                return std::nullopt;
+            }
+        } else if (arg == "--threads") {
+            const auto threads = value();
+            if (!threads || !parseValue(*threads, options.threads)) {
+                return std::nullopt;
+            }
+        } else if (arg == "--output") {
+            const auto output = value();
+            if (!output) {
+                return std::nullopt;
+            }
+            options.output = *output;
+        } else if (arg == "--save") {
+            const auto save = value();
+            if (!save) {
+                return std::nullopt;
+            }
+            options.save = *save;
+        } else if (arg.starts_with("--")) {
+            std::println(std::cerr, "unknown option {}", arg);
+            return std::nullopt;
+        } else {
+            options.inputs.emplace_back(arg);
+        }
+    }
+    return options;
+}
+
+bool isPathFile(const std::string& fileName)
+{
+    std::ifstream in(fileName, std::ios::binary);
+    std::array<char, kPathFileMagic.size()> magic = {};
+    return in.read(magic.data(), static_cast<std::streamsize>(magic.size())) && magic == kPathFileMagic;
+}
+
+// The inputs in order, one path at a time: text through a PathReader, binary path files mapped.
+struct PathSource
+{
+    explicit PathSource(const std::vector<std::string>& inputs) : _inputs(inputs) {}
+
+    //! Read the next path into path. False at the end of the inputs, or after reporting bad input.
+    bool next(Path& path)
+    {
+        while (!_failed) {
+            if (_reader) {
+                if (_reader->next(path)) {
+                    return true;
+                }
+                if (!_reader->error().empty()) {
+                    return fail(_reader->error());
+                }
+                _reader.reset();
+                _file.close();
+            } else if (_mappedIndex < _mapped.pathCount()) {
+                _mapped.path(_mappedIndex).toPath(path);
+                if (!validatePath(path)) {
+                    return fail(std::format("{}: path {} is not increasing in time and progress", _inputs[_nextInput - 1], _mappedIndex));
+                }
+                ++_mappedIndex;
+                return true;
+            } else if (!openNext()) {
+                return false;
+            }
+        }
+        return false;
+    }
+
+    [[nodiscard]] bool failed() const { return _failed; }
+
+    // internal (private)
+    bool openNext()
+    {
+        _mapped.close();
+        _mappedIndex = 0;
+        if (_inputs.empty() && _nextInput == 0) {
+            ++_nextInput;
+            _reader.emplace(std::cin, "<stdin>");
+            return true;
+        }
+        if (_nextInput >= _inputs.size()) {
+            return false;
+        }
+        const std::string& input = _inputs[_nextInput++];
+        if (isPathFile(input)) {
+            std::string error;
+            return _mapped.open(input, error) || fail(error);
+        }
+        _file.open(input);
+        if (!_file) {
+            return fail(std::format("can't open {}", input));
+        }
+        _reader.emplace(_file, input);
+        return true;
+    }
+
+    bool fail(const std::string_view error)
+    {
+        std::println(std::cerr, "{}", error);
+        _failed = true;
+        return false;
+    }
+
+    const std::vector<std::string>&     _inputs;
+    size_t                              _nextInput      = 0;
+    std::ifstream                       _file           = {};
+    std::optional<PathReader>           _reader         = {};
+    MappedPathFile                      _mapped         = {};
+    size_t                              _mappedIndex    = 0;
+    bool                                _failed         = false;
+};
+
+// Paths read, solved and written together. The following chunks reuse its buffers.
+struct Chunk
+{
+    std::vector<Path>               paths           = {};   // only the first count are current
+    size_t                          count           = 0;
+    BatchSolution                   solution        = {};
+
+    [[nodiscard]] std::span<Path> current() { return std::span(paths).first(count); }
+
+    void fill(PathSource& source, const size_t maxCheckpoints)
+    {
+        count = 0;
+        for (size_t checkpoints = 0; checkpoints < maxCheckpoints; ++count) {
+            if (count == paths.size()) {
+                paths.emplace_back();
+            }
+            if (!source.next(paths[count])) {
+                return;
+            }
+            checkpoints += paths[count].checkpoints.size() + 1;
+        }
+    }
+};
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    const std::optional<BatchOptions> options = parseOptions(std::span(argv, static_cast<size_t>(argc)));
+    if (!options) {
+        printUsage();
+        return 2;
+    }
+
+    std::ofstream file;
+    if (!options->output.empty()) {
+        file.open(options->output);
+        if (!file) {
+            std::println(std::cerr, "can't create {}", options->output);
+            return 1;
+        }
+    }
+    std::ostream& out = options->output.empty() ? std::cout : file;
+
+    const BatchSettings settings {
+        .easeInOut              = options->easeInOut,
+        .solverMode             = options->solverMode,
+        .adjustEase             = true,
+        .tessellate             = options->tessellate,
+        .tessellationTolerance  = options->tolerance,
+        .progressSamples        = options->samples,
+    };
+    PathSource source(options->inputs);
+    SolvedPathWriter writer(out);
+    std::vector<Path> saved;
+    std::vector<float> savedVelocities;
+    auto write = [&](Chunk& chunk) {
+        for (size_t index = 0; index < chunk.count; ++index) {
+            writer.write(chunk.solution, index, options->samples);
+        }
+        if (!options->save.empty()) {
+            const std::span<Path> paths = chunk.current();
+            saved.insert(saved.end(), paths.begin(), paths.end());
+            savedVelocities.insert(savedVelocities.end(), chunk.solution.velocities.begin(), chunk.solution.velocities.end());
+        }
+    };
+
+    // two chunks in flight: while the workers solve one, this thread writes the one before it and
+    // reads the one after it
+    {
+        WorkerPool pool(options->threads);
+        std::array<Chunk, 2> chunks;
+        size_t current = 0;
+        bool solvedAny = false;
+        chunks[current].fill(source, options->chunk);
+        while (chunks[current].count > 0) {
+            Chunk& chunk = chunks[current];
+            Chunk& other = chunks[1 - current];
+            std::future<void> solving = std::async(std::launch::async, [&chunk, &settings, &pool] { solveBatch(chunk.current(), settings, pool, chunk.solution); });
+            if (solvedAny) {
+                write(other);
+            }
+            other.fill(source, options->chunk);
+            solving.get();
+            solvedAny = true;
+            current = 1 - current;
+        }
+        if (solvedAny) {
+            write(chunks[1 - current]);
+        }
+    }
+
+    if (!options->save.empty()) {
+        std::string error;
+        if (!writePathFile(options->save, saved, savedVelocities, error)) {
+            std::println(std::cerr, "{}", error);
+            return 1;
+        }
+    }
+
+    out.flush();
+    if (!out) {
+        std::println(std::cerr, "can't write {}", options->output.empty() ? "<stdout>" : options->output);
+        return 1;
+    }
+    return source.failed() ? 1 : 0;
+}
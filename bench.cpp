@@ -0,0 +1,656 @@
+// Benchmarks of the solver, the tessellation and EaseCurve on generated inputs of 1 to 10k
+// checkpoints, written as JSON to compare runs and catch regressions. The inputs come from a fixed
+// seed and a generator that doesn't depend on the standard library's distributions, so every
+// platform measures the same paths. Progress goes to stderr. Accuracy checks run next to some of the
+// benchmarks, reported with them; one that fails makes the exit code 1.
+
+import std;
+
+import main.easecurve;
+import main.solver;
+
+namespace {
+
+struct BenchOptions
+{
+    std::string                     filter              = {};       // only names containing it
+    double                          minTime             = 0.2;      // seconds per benchmark
+    size_t                          maxCheckpoints      = 10000;
+    std::string                     output              = {};       // stdout when empty
+};
+
+struct Measurement
+{
+    std::string                     name                = {};
+    size_t                          checkpoints         = 0;
+    size_t                          items               = 1;        // queries or samples per operation
+    size_t                          operations          = 0;        // timed in total
+    double                          minNs               = 0.;       // per operation
+    double                          medianNs            = 0.;
+    double                          meanNs              = 0.;
+    int                             steps               = 0;        // solver steps, where it applies
+    std::vector<std::pair<std::string, double>> values  = {};       // results of the checks run with it
+};
+
+constexpr std::array<size_t, 5> kCheckpointCounts   = { 1, 10, 100, 1000, 10000 };
+constexpr std::array<size_t, 3> kSampleCounts       = { 1000, 100000, 1000000 };
+constexpr size_t                kQueryCount         = 1024;
+constexpr float                 kLargeRadius        = 10.f;     // about the gap between generated curve points
+// the analytic reduction and bisection both stop about _precision from where the circles clear each
+// other, so the radii they reduce to agree within this many of it
+constexpr float                 kReductionMaxError  = 1000.f;
+// a local restart gives the circles of a full solve exactly, so the values differ by rounding at most,
+// relative to the curve's height
+constexpr float                 kRestartMaxError    = 4.f * std::numeric_limits<float>::epsilon();
+constexpr size_t                kMinSamples         = 5;
+constexpr size_t                kMaxSamples         = 1000;
+constexpr size_t                kMaxRepeat          = 1 << 20;
+constexpr auto                  kMinSampleTime      = std::chrono::microseconds(20);
+
+// written with the results, so the optimizer can't drop the work producing them
+volatile float sink = 0.f;
+
+// Uniform floats from the raw engine output, which the standard pins down, unlike the distributions.
+struct Random
+{
+    std::mt19937                    engine;
+
+    float next(const float low, const float high)
+    {
+        return low + (high - low) * static_cast<float>(engine() >> 8) * 0x1p-24f;
+    }
+};
+
+void printUsage()
+{
+    std::println(std::cerr, "usage: easecurve-bench [options]");
+    std::println(std::cerr, "  --filter <text>             only run the benchmarks with text in their name");
+    std::println(std::cerr, "  --min-time <seconds>        time spent on each benchmark (0.2)");
+    std::println(std::cerr, "  --max-checkpoints <count>   skip the larger inputs (10000)");
+    std::println(std::cerr, "  --output <file>             write the JSON to a file instead of stdout");
+}
+
+template <typename T>
+bool parseValue(const std::string_view text, T& value)
+{
+    std::istringstream stream { std::string(text) };
+    return (stream >> value) && (stream >> std::ws).eof();
+}
+
+std::optional<BenchOptions> parseOptions(const std::span<char*> args)
+{
+    BenchOptions options;
+    for (size_t index = 1; index < args.size(); ++index) {
+        const std::string_view arg = args[index];
+        if (index + 1 >= args.size()) {
+            std::println(std::cerr, "missing value for {}", arg);
+            return std::nullopt;
+        }
+        const std::string_view value = args[++index];
+        if (arg == "--filter") {
+            options.filter = value;
+        } else if (arg == "--min-time") {
+            if (!parseValue(value, options.minTime)) {
+                return std::nullopt;
+            }
+        } else if (arg == "--max-checkpoints") {
+            if (!parseValue(value, options.maxCheckpoints)) {
+                return std::nullopt;
+            }
+        } else if (arg == "--output") {
+            options.output = value;
+        } else {
+            std::println(std::cerr, "unknown option {}", arg);
+            return std::nullopt;
+        }
+    }
+    return options;
+}
+
+// Checkpoints about a second and a unit of progress apart, with eases that fit between them, so
+// the adjusted eases equal the requested ones and every variant solves the same system.
+Path generatePath(const size_t checkpoints)
+{
+    Random random { std::mt19937(static_cast<std::mt19937::result_type>(checkpoints)) };
+    Path path {
+        .startTime          = 0.f,
+        .startProgress      = 0.f,
+        .startVelocity      = 0.f,
+        .startEaseDuration  = 0.4f,
+        .endVelocity        = 0.f,
+        .endEaseDuration    = 0.4f,
+    };
+    float time = 0.f;
+    float progress = 0.f;
+    path.checkpoints.reserve(checkpoints);
+    for (size_t index = 0; index < checkpoints; ++index) {
+        time += random.next(0.8f, 1.2f);
+        progress += random.next(0.5f, 1.5f);
+        path.checkpoints.push_back({ .time = time, .progress = progress, .easeDuration = random.next(0.1f, 0.7f) });
+    }
+    path.endTime = time + random.next(0.8f, 1.2f);
+    path.endProgress = progress + random.next(0.5f, 1.5f);
+    adjustEaseDurationsP(path);
+    return path;
+}
+
+// Points about 10 apart on both axes. They are set directly, as addPoint() solves after each one.
+EaseCurve generateCurve(const size_t points)
+{
+    Random random { std::mt19937(static_cast<std::mt19937::result_type>(points)) };
+    EaseCurve curve;
+    float x = 0.f;
+    float y = 0.f;
+    for (size_t index = 0; index < points; ++index) {
+        x += random.next(8.f, 12.f);
+        y += random.next(5.f, 15.f);
+        EaseCurve::PointRecord record;
+        record.point = {{ x, y }};
+        record.radius = curve._radius;
+        curve._pointRecords.push_back(record);
+    }
+    curve.setLastPoint(x + random.next(8.f, 12.f), y + random.next(5.f, 15.f));
+    return curve;
+}
+
+struct Bench
+{
+    const BenchOptions&             options;
+    std::vector<Measurement>        results             = {};
+    bool                            failed              = false;    // a check failed
+
+    [[nodiscard]] bool selected(const std::string_view name) const { return name.contains(options.filter); }
+
+    //! Time body, which does items of work per call. Fast bodies are repeated within a sample so
+    //! that each sample is long enough for the clock.
+    template <typename Body>
+    void measure(const std::string_view name, const size_t checkpoints, const size_t items, Body&& body)
+    {
+        if (!selected(name)) {
+            return;
+        }
+        using Clock = std::chrono::steady_clock;
+        auto run = [&](const size_t repeat) {
+            const Clock::time_point start = Clock::now();
+            for (size_t index = 0; index < repeat; ++index) {
+                body();
+            }
+            return Clock::now() - start;
+        };
+
+        // calibrating doubles as the warm-up
+        size_t repeat = 1;
+        while (run(repeat) < kMinSampleTime && repeat < kMaxRepeat) {
+            repeat *= 2;
+        }
+
+        std::vector<double> samples;
+        const std::chrono::duration<double> minTime(options.minTime);
+        Clock::duration elapsed {};
+        while (samples.size() < kMinSamples || (elapsed < minTime && samples.size() < kMaxSamples)) {
+            const Clock::duration duration = run(repeat);
+            elapsed += duration;
+            samples.push_back(std::chrono::duration<double, std::nano>(duration).count() / static_cast<double>(repeat));
+        }
+        std::ranges::sort(samples);
+
+        const Measurement& result = results.emplace_back(Measurement {
+            .name           = std::string(name),
+            .checkpoints    = checkpoints,
+            .items          = items,
+            .operations     = samples.size() * repeat,
+            .minNs          = samples.front(),
+            .medianNs       = samples[samples.size() / 2],
+            .meanNs         = std::accumulate(samples.begin(), samples.end(), 0.) / static_cast<double>(samples.size()),
+        });
+        std::println(std::cerr, "{:<28} {:>6} {:>8} {:>16.1f} ns", result.name, result.checkpoints, result.items, result.medianNs);
+    }
+
+    //! Record the solver steps of the last measurement, if it ran.
+    void steps(const std::string_view name, const int count)
+    {
+        if (!results.empty() && results.back().name == name) {
+            results.back().steps = count;
+        }
+    }
+
+    //! Record a check result with the last measurement, if it ran.
+    void value(const std::string_view name, const std::string_view key, const double number)
+    {
+        if (!results.empty() && results.back().name == name) {
+            results.back().values.emplace_back(std::string(key), number);
+        }
+    }
+};
+
+// The largest difference of the lane kernel from the scalar reference per channel, and whether every
+// sample is within the bound evaluateBatchLanes() documents.
+struct LaneErrors
+{
+    float                           progress            = 0.f;
+    float                           velocity            = 0.f;
+    float                           accel               = 0.f;
+    bool                            withinBound         = true;
+};
+
+LaneErrors compareLanes(const SegmentTable& segments, const std::span<const float> times,
+                        const std::span<const float> progress, const std::span<const float> velocity, const std::span<const float> accel,
+                        const std::span<const float> laneProgress, const std::span<const float> laneVelocity, const std::span<const float> laneAccel)
+{
+    LaneErrors errors;
+    // scale is what the ease error gets multiplied by; the two kernels may also round the sums
+    // differently, by a few ulps of the value and of the eased term
+    auto check = [&errors](float& maxError, const float reference, const float lane, const float scale) {
+        const float error = std::abs(lane - reference);
+        maxError = std::max(maxError, error);
+        const float rounding = 4.f * std::numeric_limits<float>::epsilon() * (std::abs(reference) + scale);
+        if (!(error <= kLaneEaseMaxError * scale + rounding)) {
+            errors.withinBound = false;
+        }
+    };
+    for (size_t index = 0; index < times.size(); ++index) {
+        // outside the segments both kernels return the same constants
+        float deltaVelocity = 0.f;
+        float duration = 1.f;
+        const auto it = std::ranges::upper_bound(segments.times, times[index]);
+        if (it != segments.times.begin() && it != segments.times.end()) {
+            const auto segment = static_cast<size_t>(it - segments.times.begin()) - 1;
+            deltaVelocity = std::abs(segments.velocities[segment + 1] - segments.velocities[segment]);
+            duration = segments.times[segment + 1] - segments.times[segment];
+        }
+        check(errors.progress, progress[index], laneProgress[index], deltaVelocity * duration);
+        check(errors.velocity, velocity[index], laneVelocity[index], deltaVelocity);
+        check(errors.accel, accel[index], laneAccel[index], deltaVelocity / duration);
+    }
+    return errors;
+}
+
+void benchPath(Bench& bench, const size_t checkpoints)
+{
+    const Path path = generatePath(checkpoints);
+
+    using Adjust = void (*)(Path&);
+    const std::array<std::pair<std::string_view, Adjust>, 3> adjusts = {{
+        { "adjustEaseDurationsP", adjustEaseDurationsP },
+        { "adjustEaseDurations1", adjustEaseDurations1 },
+        { "adjustEaseDurations2", adjustEaseDurations2 },
+    }};
+    for (const auto& [name, adjust] : adjusts) {
+        Path adjusted = path;
+        bench.measure(name, checkpoints, 1, [&] {
+            adjust(adjusted);
+            sink = adjusted.adjustedEndEaseDuration;
+        });
+    }
+
+    for (const auto& [name, mode] : { std::pair { "solve/iterative", SolverMode::Iterative }, std::pair { "solve/direct", SolverMode::Direct } }) {
+        const SolveInput input { .path = path, .solverMode = mode, .tessellationTolerance = 1e-4f * path.endProgress };
+        SolveHistory history;
+        bench.measure(name, checkpoints, 1, [&] {
+            solve(input, EaseInOut::Sine, history);
+            sink = static_cast<float>(history.errors.back());
+        });
+        bench.steps(name, history.stepCount());
+    }
+
+    SolveInput input { .path = path, .solverMode = SolverMode::Direct, .tessellationTolerance = 1e-4f * path.endProgress };
+    SolveHistory history;
+    solve(input, EaseInOut::Sine, history);
+    const int lastStep = history.stepCount() - 1;
+    bench.measure("tessellate", checkpoints, 1, [&] {
+        history.selectedStep = -1;
+        sink = selectStep(input, history, lastStep).tessellatedProgress.back().y();
+    });
+
+    // an ease slider drag: one ease toggling between two durations, re-solved and re-tessellated
+    // around it
+    {
+        const size_t middle = checkpoints / 2;
+        const float easeDuration = input.path.checkpoints[middle].adjustedEaseDuration;
+        bool shrunk = false;
+        selectStep(input, history, lastStep);
+        bench.measure("solveIncremental", checkpoints, 1, [&] {
+            shrunk = !shrunk;
+            input.path.checkpoints[middle].adjustedEaseDuration = shrunk ? easeDuration / 2 : easeDuration;
+            const auto [firstEase, lastEase] = alignEaseDurations(input.path, static_cast<int>(middle));
+            solveIncremental(input, history, firstEase, lastEase);
+            sink = history.selected.tessellatedProgress.back().y();
+        });
+        input.path.checkpoints[middle].adjustedEaseDuration = easeDuration;
+        alignEaseDurations(input.path, static_cast<int>(middle));
+    }
+
+    const Result& result = selectStep(input, history, lastStep);
+    {
+        Random random { std::mt19937(static_cast<std::mt19937::result_type>(checkpoints)) };
+        std::vector<float> times(kQueryCount);
+        for (float& time : times) {
+            time = random.next(path.startTime, path.endTime);
+        }
+        bench.measure("progressAt", checkpoints, kQueryCount, [&] {
+            float sum = 0.f;
+            for (const float time : times) {
+                sum += progressAt(input.path, result, time);
+            }
+            sink = sum;
+        });
+    }
+
+    for (const size_t sampleCount : kSampleCounts) {
+        std::vector<float> times(sampleCount);
+        std::vector<float> progress(sampleCount);
+        std::vector<float> velocity(sampleCount);
+        std::vector<float> accel(sampleCount);
+        const float step = (path.endTime - path.startTime) / static_cast<float>(sampleCount - 1);
+        for (size_t index = 0; index < sampleCount; ++index) {
+            times[index] = path.startTime + step * static_cast<float>(index);
+        }
+        bench.measure("evaluateBatch", checkpoints, sampleCount, [&] {
+            evaluateBatch(input.path, result, times, progress, velocity, accel);
+            sink = progress.back();
+        });
+        bench.measure("evaluateBatchLanes", checkpoints, sampleCount, [&] {
+            evaluateBatchLanes(input.path, result, times, progress, velocity, accel);
+            sink = progress.back();
+        });
+
+        if (bench.selected("evaluateBatchLanes")) {
+            std::vector<float> laneProgress(sampleCount);
+            std::vector<float> laneVelocity(sampleCount);
+            std::vector<float> laneAccel(sampleCount);
+            evaluateBatch(input.path, result, times, progress, velocity, accel);
+            evaluateBatchLanes(input.path, result, times, laneProgress, laneVelocity, laneAccel);
+            const LaneErrors errors = compareLanes(result.segments, times, progress, velocity, accel, laneProgress, laneVelocity, laneAccel);
+            bench.value("evaluateBatchLanes", "max_progress_error", static_cast<double>(errors.progress));
+            bench.value("evaluateBatchLanes", "max_velocity_error", static_cast<double>(errors.velocity));
+            bench.value("evaluateBatchLanes", "max_accel_error", static_cast<double>(errors.accel));
+            bench.value("evaluateBatchLanes", "within_bound", errors.withinBound ? 1. : 0.);
+            if (!errors.withinBound) {
+                std::println(std::cerr, "evaluateBatchLanes differs from evaluateBatch by more than kLaneEaseMaxError allows, {} checkpoints, {} samples", checkpoints, sampleCount);
+                bench.failed = true;
+            }
+        }
+    }
+}
+
+// kQueryCount xs over the whole curve, the same on every run.
+std::vector<float> generateQueries(const EaseCurve& curve, const size_t points)
+{
+    Random random { std::mt19937(static_cast<std::mt19937::result_type>(points)) };
+    std::vector<float> xs(kQueryCount);
+    for (float& x : xs) {
+        x = random.next(0.f, curve._lastPoint.x());
+    }
+    return xs;
+}
+
+// The largest difference between the values of two curves at xs.
+float maxDifference(const EaseCurve& curve, const EaseCurve& other, const std::span<const float> xs)
+{
+    float difference = 0.f;
+    for (const float x : xs) {
+        difference = std::max(difference, std::abs(curve.evaluate(x) - other.evaluate(x)));
+    }
+    return difference;
+}
+
+void benchCurve(Bench& bench, const size_t points)
+{
+    EaseCurve curve = generateCurve(points);
+    bench.measure("EaseCurve::solve", points, 1, [&] {
+        curve.solve();
+        sink = curve._scaledSegments.back().finalX;
+    });
+
+    const std::vector<float> xs = generateQueries(curve, points);
+
+    if (points >= 2) {
+        // a point halfway between two in the middle, touching only the pairs around it
+        const int middle = static_cast<int>(points / 2);
+        const EaseCurve::Point inserted = (curve._pointRecords[points / 2 - 1].point + curve._pointRecords[points / 2].point) * .5f;
+        bench.measure("EaseCurve::insertPointAt+removePointAt", points, 1, [&] {
+            curve.insertPointAt(middle, inserted.x(), inserted.y());
+            curve.removePointAt(middle);
+            sink = curve._scaledSegments.back().finalX;
+        });
+    }
+    bench.measure("EaseCurve::evaluate", points, kQueryCount, [&] {
+        float sum = 0.f;
+        for (const float x : xs) {
+            sum += curve.evaluate(x);
+        }
+        sink = sum;
+    });
+
+    std::vector<float> sweep = xs;
+    std::ranges::sort(sweep);
+    bench.measure("EaseCurve::Sampler", points, kQueryCount, [&] {
+        EaseCurve::Sampler sampler = curve.sampler();
+        float sum = 0.f;
+        for (const float x : sweep) {
+            sum += sampler.evaluate(x);
+        }
+        sink = sum;
+    });
+
+    std::vector<float> values(kQueryCount);
+    std::vector<float> speeds(kQueryCount);
+    std::vector<float> accels(kQueryCount);
+    bench.measure("EaseCurve::evaluateBatch", points, kQueryCount, [&] {
+        curve.evaluateBatch(sweep, values, speeds, accels);
+        sink = values.back();
+    });
+}
+
+// The curve of generateCurve() with radii as large as the gaps between its points, so that most
+// pairs overlap and get reduced, and some circles flip.
+EaseCurve generateOverlappingCurve(const size_t points)
+{
+    EaseCurve curve = generateCurve(points);
+    curve._radius = kLargeRadius;
+    curve.setRadius();
+    return curve;
+}
+
+// How a locally re-solved curve differs from the same curve solved from scratch.
+struct RestartErrors
+{
+    float                           difference          = 0.f;      // the largest between the values at xs
+    bool                            sameCircles         = true;     // reduced radii and sides, exactly
+};
+
+RestartErrors compareWithSolve(const EaseCurve& curve, const std::span<const float> xs)
+{
+    EaseCurve solved = curve;
+    solved.solve();
+    RestartErrors errors { .difference = maxDifference(curve, solved, xs) };
+    errors.sameCircles = curve._scaledSegments.size() == solved._scaledSegments.size()
+        && curve._firstReducedRadius == solved._firstReducedRadius && curve._lastReducedRadius == solved._lastReducedRadius;
+    for (size_t index = 0; index < curve._pointRecords.size(); ++index) {
+        const EaseCurve::PointRecord& record = curve._pointRecords[index];
+        const EaseCurve::PointRecord& other = solved._pointRecords[index];
+        if (record.reducedRadius != other.reducedRadius || record.autoSide != other.autoSide
+            || record.has(EaseCurve::PointRecord::kAbove) != other.has(EaseCurve::PointRecord::kAbove)) {
+            errors.sameCircles = false;
+        }
+    }
+    return errors;
+}
+
+// Inserting a point and removing it again re-solves locally, which must leave each step as solve()
+// does, next to the first point, in the middle and next to the last point.
+void checkLocalRestarts(Bench& bench, const EaseCurve& overlapping, const std::span<const float> xs)
+{
+    constexpr std::string_view kName = "EaseCurve::insertPointAt+removePointAt/overlapping";
+    const size_t points = overlapping._pointRecords.size();
+    RestartErrors worst;
+    auto check = [&](const EaseCurve& curve) {
+        const RestartErrors errors = compareWithSolve(curve, xs);
+        worst.difference = std::max(worst.difference, errors.difference);
+        worst.sameCircles = worst.sameCircles && errors.sameCircles;
+    };
+    for (const size_t position : { size_t { 0 }, points / 2, points }) {
+        EaseCurve curve = overlapping;
+        const EaseCurve::Point prev = position == 0 ? EaseCurve::kFirstPoint : curve._pointRecords[position - 1].point;
+        const EaseCurve::Point next = position == points ? curve._lastPoint : curve._pointRecords[position].point;
+        const EaseCurve::Point inserted = (prev + next) * .5f;
+        curve.insertPointAt(static_cast<int>(position), inserted.x(), inserted.y());
+        check(curve);
+        curve.removePointAt(static_cast<int>(position));
+        check(curve);
+    }
+    const bool withinBound = worst.difference <= kRestartMaxError * overlapping._lastPoint.y();
+    bench.value(kName, "max_y_difference", static_cast<double>(worst.difference));
+    bench.value(kName, "same_circles", worst.sameCircles ? 1. : 0.);
+    if (!worst.sameCircles || !withinBound) {
+        std::println(std::cerr, "{} differs from EaseCurve::solve, {} points", kName, points);
+        bench.failed = true;
+    }
+}
+
+// How the curve solved with the analytic reduction differs from the one bisecting the radii, and whether
+// that is within the bounds: each reduced radius within kReductionMaxError of _precision, on the same
+// side, and the values within twice that, a circle moving by its radius change and the tangents
+// joining it by about as much again.
+struct ReductionErrors
+{
+    float                           radius              = 0.f;
+    float                           difference          = 0.f;      // the largest between the values at xs
+    bool                            reduced             = false;    // any radius at all
+    bool                            withinBound         = true;
+};
+
+ReductionErrors compareReductions(const EaseCurve& analytic, const EaseCurve& bisected, const std::span<const float> xs)
+{
+    ReductionErrors errors { .difference = maxDifference(analytic, bisected, xs) };
+    bool sameSides = analytic._scaledSegments.size() == bisected._scaledSegments.size();
+    auto compare = [&](const float radius, const float analyticRadius, const float bisectedRadius) {
+        errors.radius = std::max(errors.radius, std::abs(analyticRadius - bisectedRadius));
+        errors.reduced = errors.reduced || analyticRadius < radius || bisectedRadius < radius;
+    };
+    compare(analytic._firstRadius, analytic._firstReducedRadius, bisected._firstReducedRadius);
+    compare(analytic._lastRadius, analytic._lastReducedRadius, bisected._lastReducedRadius);
+    for (size_t index = 0; index < analytic._pointRecords.size(); ++index) {
+        const EaseCurve::PointRecord& record = analytic._pointRecords[index];
+        const EaseCurve::PointRecord& other = bisected._pointRecords[index];
+        compare(record.radius, record.reducedRadius, other.reducedRadius);
+        if (record.autoSide != other.autoSide || record.has(EaseCurve::PointRecord::kAbove) != other.has(EaseCurve::PointRecord::kAbove)) {
+            sameSides = false;
+        }
+    }
+    const float radiusBound = kReductionMaxError * analytic._precision;
+    errors.withinBound = sameSides && errors.radius <= radiusBound && errors.difference <= 2.f * radiusBound;
+    return errors;
+}
+
+// The overlapping curve solved with both ways of reducing the radii, and re-solved locally.
+void benchReduction(Bench& bench, const size_t points)
+{
+    EaseCurve analytic = generateOverlappingCurve(points);
+    EaseCurve bisected = analytic;
+    const std::vector<float> xs = generateQueries(analytic, points);
+    bisected._analyticReduction = false;
+
+    bench.measure("EaseCurve::solve/analytic", points, 1, [&] {
+        analytic.solve();
+        sink = analytic._scaledSegments.back().finalX;
+    });
+    bench.steps("EaseCurve::solve/analytic", analytic._iterations);
+    bench.measure("EaseCurve::solve/bisected", points, 1, [&] {
+        bisected.solve();
+        sink = bisected._scaledSegments.back().finalX;
+    });
+    bench.steps("EaseCurve::solve/bisected", bisected._iterations);
+
+    if (bench.selected("EaseCurve::solve/bisected")) {
+        analytic.solve();
+        bisected.solve();
+        const ReductionErrors errors = compareReductions(analytic, bisected, xs);
+        bench.value("EaseCurve::solve/bisected", "analytic_steps", static_cast<double>(analytic._iterations));
+        bench.value("EaseCurve::solve/bisected", "max_radius_error", static_cast<double>(errors.radius));
+        bench.value("EaseCurve::solve/bisected", "max_y_difference", static_cast<double>(errors.difference));
+        bench.value("EaseCurve::solve/bisected", "within_bound", errors.withinBound ? 1. : 0.);
+        if (!errors.withinBound) {
+            std::println(std::cerr, "the analytic reduction differs from bisecting by more than kReductionMaxError allows, {} points", points);
+            bench.failed = true;
+        }
+        // without anything to reduce both take the same steps
+        if (errors.reduced && analytic._iterations >= bisected._iterations) {
+            std::println(std::cerr, "the analytic reduction takes {} steps, bisecting {}, {} points", analytic._iterations, bisected._iterations, points);
+            bench.failed = true;
+        }
+    }
+
+    const int middle = static_cast<int>(points / 2);
+    const EaseCurve::Point prev = middle == 0 ? EaseCurve::kFirstPoint : analytic._pointRecords[points / 2 - 1].point;
+    const EaseCurve::Point inserted = (prev + analytic._pointRecords[points / 2].point) * .5f;
+    EaseCurve restarted = analytic;
+    bench.measure("EaseCurve::insertPointAt+removePointAt/overlapping", points, 1, [&] {
+        restarted.insertPointAt(middle, inserted.x(), inserted.y());
+        restarted.removePointAt(middle);
+        sink = restarted._scaledSegments.back().finalX;
+    });
+    if (bench.selected("EaseCurve::insertPointAt+removePointAt/overlapping")) {
+        analytic.solve();
+        checkLocalRestarts(bench, analytic, xs);
+    }
+}
+
+void writeJson(std::ostream& out, const BenchOptions& options, const std::vector<Measurement>& results)
+{
+    std::println(out, "{{");
+    std::println(out, "  \"version\": 1,");
+    std::println(out, "  \"min_time_s\": {},", options.minTime);
+    std::println(out, "  \"results\": [");
+    for (size_t index = 0; index < results.size(); ++index) {
+        const Measurement& result = results[index];
+        std::print(out, "    {{\"name\": \"{}\", \"checkpoints\": {}, \"items\": {}, \"operations\": {}, \"min_ns\": {:.1f}, \"median_ns\": {:.1f}, \"mean_ns\": {:.1f}",
+                   result.name, result.checkpoints, result.items, result.operations, result.minNs, result.medianNs, result.meanNs);
+        if (result.steps > 0) {
+            std::print(out, ", \"steps\": {}", result.steps);
+        }
+        for (const auto& [key, value] : result.values) {
+            std::print(out, ", \"{}\": {}", key, value);
+        }
+        std::println(out, "}}{}", index + 1 < results.size() ? "," : "");
+    }
+    std::println(out, "  ]");
+    std::println(out, "}}");
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    const std::optional<BenchOptions> options = parseOptions(std::span(argv, static_cast<size_t>(argc)));
+    if (!options) {
+        printUsage();
+        return 2;
+    }
+
+    Bench bench { .options = *options };
+    for (const size_t checkpoints : kCheckpointCounts) {
+        if (checkpoints <= options->maxCheckpoints) {
+            benchPath(bench, checkpoints);
+            benchCurve(bench, checkpoints);
+            benchReduction(bench, checkpoints);
+        }
+    }
+
+    std::ofstream file;
+    if (!options->output.empty()) {
+        file.open(options->output);
+        if (!file) {
+            std::println(std::cerr, "can't create {}", options->output);
+            return 1;
+        }
+    }
+    std::ostream& out = options->output.empty() ? std::cout : file;
+    writeJson(out, *options, bench.results);
+    out.flush();
+    if (!out) {
+        std::println(std::cerr, "can't write {}", options->output.empty() ? "<stdout>" : options->output);
+        return 1;
+    }
+    return bench.failed ? 1 : 0;
+}
@@ -12,6 +12,15 @@ import alx.assert;
 import alx.va;
 
 import main.appstate;
+import main.pathfile;
+import main.pathstream;
+import main.profile;
+
+#if defined(EASECURVE_COUNT_ALLOCATIONS)
+// in src/allocations.cpp, next to the replaced operator new
+std::uint64_t countedAllocatedBytes();
+std::uint64_t countedAllocationCount();
+#endif
 
 using namespace sokol::color;
 namespace im = ImGui;
@@ -120,8 +129,7 @@ void init(AppState& app)
             { .time = 58.137657f,   .progress = 0.865331f,  .easeDuration= 5.0f },
         }
     };
-    solve(app, app._resultsLinear, true);
-    solve(app, app._resultsSine, true);
+    launchSolve(app, true);
 
     fixAspectRatio(app);
 }
@@ -351,12 +359,135 @@ bool ColorEditAlpha(const char* label, sg_color& color)
 //    }
 //}
 
+constexpr std::string_view kPathFileName = "easecurve.path";
+
+void savePath(const AppState& app)
+{
+    const std::array<Path, 1> paths = { app._path };
+    std::string error;
+    if (!writePathFile(kPathFileName, paths, {}, error)) {
+        std::println(std::cerr, "{}", error);
+    }
+}
+
+void loadPath(AppState& app)
+{
+    MappedPathFile file;
+    std::string error;
+    if (!file.open(kPathFileName, error)) {
+        std::println(std::cerr, "{}", error);
+        return;
+    }
+    if (file.pathCount() == 0) {
+        return;
+    }
+    Path path = file.path(0).toPath();
+    if (!validatePath(path)) {
+        std::println(std::cerr, "{}: the path doesn't increase in time and progress", kPathFileName);
+        return;
+    }
+    // the saved path carries the eases it was adjusted to, adjusted again if they don't fit
+    const bool adjustEase = !adjustedEasesFit(path);
+    app._path = std::move(path);
+    launchSolve(app, adjustEase);
+    fixAspectRatio(app);
+}
+
+constexpr std::string_view kTraceFileName = "easecurve.trace.json";
+
+void exportTrace()
+{
+    std::string error;
+    if (!profiler().writeChromeTrace(kTraceFileName, error)) {
+        std::println(std::cerr, "{}", error);
+    }
+}
+
+void showProfile()
+{
+    bool enabled = profiler().enabled();
+    if (im::Checkbox("Record", &enabled)) {
+        profiler().setEnabled(enabled);
+    }
+    for (size_t index = 0; index < kMetricCount; ++index) {
+        const auto metric = static_cast<Metric>(index);
+        const MetricHistory history = profiler().history(metric);
+        const std::string overlay = std::format("{:.0f} (max {:.0f})", history.last, history.max);
+        im::PlotHistogram(metricName(metric), history.values.data(), static_cast<int>(history.values.size()), static_cast<int>(history.next),
+                          overlay.c_str(), 0.f, std::max(history.max, 1.f), {0.f, 40.f});
+    }
+    if (im::Button("Export trace")) {
+        exportTrace();
+    }
+    im::SameLine();
+    if (im::Button("Clear")) {
+        profiler().clear();
+    }
+}
+
+constexpr std::string_view kFrameCsvFileName = "easecurve.frames.csv";
+
+// The last frames, scrolling right to left: the time of each phase and of the whole frame on a shared
+// scale, then the draw work recorded.
+void showFrameProfile(AppState& app)
+{
+    FrameProfiler& frames = app._frameProfiler;
+    constexpr size_t kHistory = FrameProfiler::kHistory;
+    std::array<std::array<float, kHistory>, kFramePhaseCount> phases;
+    std::array<float, kHistory> totals;
+    std::array<float, kHistory> drawCommands;
+    std::array<float, kHistory> vertices;
+    std::array<float, kHistory> uploaded;
+    size_t index = 0;
+    frames.forEachFrame([&](const FrameSample& sample) {
+        for (size_t phase = 0; phase < kFramePhaseCount; ++phase) {
+            phases[phase][index] = sample.phaseMs[phase];
+        }
+        totals[index] = sample.totalMs;
+        drawCommands[index] = static_cast<float>(sample.draws.drawCommands);
+        vertices[index] = static_cast<float>(sample.draws.vertices);
+        uploaded[index] = static_cast<float>(sample.draws.uploadedVertices);
+        ++index;
+    });
+    const float maxMs = std::max(*std::ranges::max_element(totals), 1.f);
+
+    im::SetNextWindowPos({static_cast<float>(sapp_width()) - 10.f, 10.f}, 0, {1.f, 0.f});
+    im::SetNextWindowBgAlpha(.7f);
+    im::Begin("Frame profile", &app._showFrameProfile);
+    const FrameSample& last = frames.last();
+    const std::string total = std::format("frame {:.2f} ms", last.totalMs);
+    im::PlotLines("total", totals.data(), static_cast<int>(kHistory), 0, total.c_str(), 0.f, maxMs, {0.f, 60.f});
+    for (size_t phase = 0; phase < kFramePhaseCount; ++phase) {
+        const std::string overlay = std::format("{:.2f} ms", last.phaseMs[phase]);
+        im::PlotLines(kFramePhaseNames[phase], phases[phase].data(), static_cast<int>(kHistory), 0, overlay.c_str(), 0.f, maxMs, {0.f, 30.f});
+    }
+    const std::string commands = std::format("{} commands", last.draws.drawCommands);
+    im::PlotLines("draws", drawCommands.data(), static_cast<int>(kHistory), 0, commands.c_str(), 0.f, std::numeric_limits<float>::max(), {0.f, 30.f});
+    const std::string vertexCount = std::format("{} vertices", last.draws.vertices);
+    im::PlotLines("vertices", vertices.data(), static_cast<int>(kHistory), 0, vertexCount.c_str(), 0.f, std::numeric_limits<float>::max(), {0.f, 30.f});
+    const std::string uploadedCount = std::format("{} uploaded", last.draws.uploadedVertices);
+    im::PlotLines("uploads", uploaded.data(), static_cast<int>(kHistory), 0, uploadedCount.c_str(), 0.f, std::numeric_limits<float>::max(), {0.f, 30.f});
+    im::Text("%u heap allocations while recording", last.draws.heapAllocations);
+
+    bool csv = frames.csvEnabled();
+    if (im::Checkbox("Dump CSV", &csv)) {
+        std::string error;
+        if (!csv) {
+            frames.stopCsv();
+        } else if (!frames.startCsv(kFrameCsvFileName, error)) {
+            std::println(std::cerr, "{}", error);
+        }
+    }
+    im::End();
+}
+
 //sg_pass_action pass_action = {};
 sg_desc desc = {};
 
 void init(void* userData)
 {
     AppState& app = *static_cast<AppState*>(userData);
+    profiler().setEnabled(true);
     init(app);
     //load(app);
 
@@ -379,12 +510,19 @@ void init(void* userData)
         std::print("Failed to create Sokol GP context: {}\n", sgp_get_error_message(sgp_get_last_error()));
         std::exit(-1);
     }
+
+    std::string error;
+    if (!app._curveRenderer.setup(error)) {
+        std::print("Failed to create the curve renderer: {}\n", error);
+        std::exit(-1);
+    }
 }
 
-void cleanup(void* /*userData*/)
+void cleanup(void* userData)
 {
-    //AppState& app = *static_cast<AppState*>(userData);
+    AppState& app = *static_cast<AppState*>(userData);
 
+    app._curveRenderer.shutdown();
     simgui_shutdown();
     sgp_shutdown();
     sg_shutdown();
@@ -435,8 +573,10 @@ void event(const sapp_event* ev, void* userData)
 
 void frame(void* userData)
 {
-    [[maybe_unused]] const auto now = std::chrono::high_resolution_clock::now();
     AppState& app = *static_cast<AppState*>(userData);
+    FrameProfiler& frames = app._frameProfiler;
+    frames.beginFrame();
+    const SolvedPath& solved = app._solver.latest();
 
     // Begin a render pass.
     const va::Vec2i windowSize = {{sapp_width(), sapp_height()}};
@@ -492,13 +632,17 @@ void frame(void* userData)
         im::Separator();
         if (im::SliderFloat("End Time", &app._path.endTime, 0.f, 100.f)) {
             fixAspectRatioByY(app);
-            solve(app, app._resultsLinear, true);
-            solve(app, app._resultsSine, true);
+            launchSolve(app, true);
         }
         if (im::SliderFloat("End Progress", &app._path.endProgress, 0.f, 100.f)) {
             fixAspectRatioByX(app);
-            solve(app, app._resultsLinear, true);
-            solve(app, app._resultsSine, true);
+            launchSolve(app, true);
+        }
+        im::Separator();
+        bool iterativeSolver = app._solverMode == SolverMode::Iterative;
+        if (im::Checkbox("Iterative solver", &iterativeSolver)) {
+            app._solverMode = iterativeSolver ? SolverMode::Iterative : SolverMode::Direct;
+            launchSolve(app, false);
         }
         //im::Separator();
         //if (im::Checkbox("Autoflip", &app._curve._autoFlip)) {
@@ -511,15 +655,19 @@ void frame(void* userData)
         //im::Text("Time: %lld us", app._curve._solveTimeUs);
     }
 
+    im::Spacing();
+    if (im::CollapsingHeader("Profile")) {
+        showProfile();
+    }
+
     im::Spacing();
     if (im::CollapsingHeader("Adjusted ease durations", ImGuiTreeNodeFlags_DefaultOpen)) {
         {
             const float maxVal = std::min(app._path.startEaseDuration, (app._path.checkpoints.empty() ? app._path.endTime : app._path.checkpoints.front().time) - app._path.startTime);
             im::PushID("easeDuration");
             if (im::SliderFloat("Start", &app._path.adjustedStartEaseDuration, 0.f, maxVal)) {
-                alignEaseDurations(app._path, -1);
-                solve(app, app._resultsLinear, false);
-                solve(app, app._resultsSine, false);
+                const auto [firstEase, lastEase] = alignEaseDurations(app._path, -1);
+                launchSolveIncremental(app, firstEase, lastEase);
             }
         }
         int i = 0;
@@ -530,9 +678,8 @@ void frame(void* userData)
             const float nextTime = i == static_cast<int>(app._path.checkpoints.size()) - 1 ? app._path.endTime : app._path.checkpoints[static_cast<size_t>(i + 1)].time;
             const float maxVal = std::min(checkpoint.easeDuration, std::min(currentTime - prevTime, nextTime - currentTime) * 2.f);
             if (im::SliderFloat(std::format("Checkpoint {}", i).c_str(), &checkpoint.adjustedEaseDuration, 0.f, maxVal)) {
-                alignEaseDurations(app._path, i);
-                solve(app, app._resultsLinear, false);
-                solve(app, app._resultsSine, false);
+                const auto [firstEase, lastEase] = alignEaseDurations(app._path, i);
+                launchSolveIncremental(app, firstEase, lastEase);
             }
             ++i;
             prevTime = currentTime;
@@ -541,24 +688,20 @@ void frame(void* userData)
         im::PopID();
         const float maxVal = std::min(app._path.endEaseDuration, app._path.endTime - prevTime);
         if (im::SliderFloat("End", &app._path.adjustedEndEaseDuration, 0.f, maxVal)) {
-            alignEaseDurations(app._path, static_cast<int>(app._path.checkpoints.size()));
-            solve(app, app._resultsLinear, false);
-            solve(app, app._resultsSine, false);
+            const auto [firstEase, lastEase] = alignEaseDurations(app._path, static_cast<int>(app._path.checkpoints.size()));
+            launchSolveIncremental(app, firstEase, lastEase);
         }
         if (im::Button("Auto calculate (P)")) {
             adjustEaseDurationsP(app._path);
-            solve(app, app._resultsLinear, false);
-            solve(app, app._resultsSine, false);
+            launchSolve(app, false);
         }
         if (im::Button("Auto calculate (C1)")) {
             adjustEaseDurations1(app._path);
-            solve(app, app._resultsLinear, false);
-            solve(app, app._resultsSine, false);
+            launchSolve(app, false);
         }
         if (im::Button("Auto calculate (C2)")) {
             adjustEaseDurations2(app._path);
-            solve(app, app._resultsLinear, false);
-            solve(app, app._resultsSine, false);
+            launchSolve(app, false);
         }
     }
     im::Spacing();
@@ -622,18 +765,32 @@ void frame(void* userData)
     im::Spacing();
     if (im::CollapsingHeader("Show", ImGuiTreeNodeFlags_DefaultOpen)) {
         if (im::Checkbox("Use non-linear (sine) easing", &app._useSineEasing)) {
-            app._selectedResults = app._useSineEasing ? &app._resultsSine : &app._resultsLinear;
+            app._selectedEaseInOut = app._useSineEasing ? EaseInOut::Sine : EaseInOut::Linear;
+        }
+        // the latest finished solve, which may lag behind the path while the solver catches up
+        const SolvedVariant& results = solved.results[static_cast<size_t>(app._selectedEaseInOut)];
+        if (results.stepCount() > 0) {
+            int selectedResult = std::min(app._selectedResult, results.stepCount() - 1);
+            if (im::SliderInt("Result Step", &selectedResult, 0, results.stepCount() - 1)) {
+                // tessellated by the solver thread, shown once it publishes it
+                launchSelectStep(app, selectedResult);
+            }
+            im::Text("Error: %f", results.errors[static_cast<size_t>(selectedResult)]);
+            const Result& result = results.selected;
+            im::Text("Points: %d", static_cast<int>(result.tessellatedProgress.size() + result.tessellatedVelocity.size() + result.tessellatedAccel.size()));
+        }
+        if (im::SliderFloat("Tolerance", &app._tessellationTolerance, 1e-6f, 1e-2f, "%.6f", ImGuiSliderFlags_Logarithmic)) {
+            launchSolve(app, false);
         }
-        int selectedResult = std::min(app._selectedResult, static_cast<int>(app._selectedResults->size()) - 1);
-        if (im::SliderInt("Result Step", &selectedResult, 0, static_cast<int>(app._selectedResults->size()) - 1)) {
-            app._selectedResult = selectedResult;
+        if (im::Checkbox("Retain full results", &app._retainFullResults)) {
+            launchSolve(app, false);
         }
-        im::Text("Error: %f", (*app._selectedResults)[static_cast<size_t>(selectedResult)].totalErrorAbs);
         //im::Checkbox("Circles", &app._showCircles);
         im::Checkbox("Speed", &app._showSpeed);
         im::Checkbox("Acceleration", &app._showAccel);
         im::Checkbox("Guides", &app._showGuides);
         im::Checkbox("Poly Line", &app._showPolyLine);
+        im::Checkbox("Frame profile", &app._showFrameProfile);
     }
 
     im::Spacing();
@@ -672,12 +829,25 @@ void frame(void* userData)
         //app._curve = {};
         //app._curve.solve();
     //}
+    if (im::Button("Save path")) {
+        savePath(app);
+    }
+    im::SameLine();
+    if (im::Button("Load path")) {
+        loadPath(app);
+    }
     if (im::Button("[Q]uit")) {
         sapp_quit();
     }
 
     im::End();
 
+    if (app._showFrameProfile) {
+        showFrameProfile(app);
+    }
+    frames.mark(FramePhase::Ui);
+
+    DrawCounters draws;
     {
         // Get current window size.
         //const float ratio = sapp_widthf()/sapp_heightf();
@@ -690,23 +860,46 @@ void frame(void* userData)
         //sgp_project(-ratio, ratio, 1.0f, -1.0f);
         sgp_project(0, static_cast<float>(windowSize.x()), 0, static_cast<float>(windowSize.y()));
 
-        render(app, (*app._selectedResults)[static_cast<size_t>(std::min(app._selectedResult, static_cast<int>(app._selectedResults->size()) - 1))]);
+        draws = render(app);
+        frames.mark(FramePhase::Record);
 
         // Dispatch all draw commands to Sokol GFX.
         sgp_flush();
         // Finish a draw command queue, clearing it.
         sgp_end();
+        frames.mark(FramePhase::Flush);
     }
 
+    // the curves go on top, from their own vertex buffers
+    const SolvedVariant& results = solved.results[static_cast<size_t>(app._selectedEaseInOut)];
+    if (results.stepCount() > 0) {
+        const Result& result = results.selected;
+        frames.mark(FramePhase::Solve);
+        draws += renderCurves(app, result);
+        frames.mark(FramePhase::Record);
+    }
+
+    // the cursor goes over the curves, so it's recorded and flushed after them
+    sgp_begin(windowSize.x(), windowSize.y());
+    sgp_viewport(0, 0, windowSize.x(), windowSize.y());
+    sgp_project(0, static_cast<float>(windowSize.x()), 0, static_cast<float>(windowSize.y()));
+    draws += renderOverlay(app);
+    frames.mark(FramePhase::Record);
+    sgp_flush();
+    sgp_end();
+    frames.mark(FramePhase::Flush);
+
     //im::ShowDemoWindow();
     //im::ShowMetricsWindow();
 
     simgui_render();
+    frames.mark(FramePhase::ImGui);
     // End render pass.
     sg_end_pass();
     // Commit Sokol render.
     sg_commit();
-    //std::println("Frame took: {}", std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - now));
+    frames.mark(FramePhase::Commit);
+    frames.endFrame(draws);
 }
 
 AppState sApp = {};
@@ -721,6 +914,9 @@ AppState sApp = {};
 
 extern "C" sapp_desc sokol_main([[maybe_unused]] int argc, [[maybe_unused]] char* argv[])
 {
+#if defined(EASECURVE_COUNT_ALLOCATIONS)
+    setAllocationCounters({ .bytes = countedAllocatedBytes, .count = countedAllocationCount });
+#endif
     return {
         .user_data = &sApp,
         .init_userdata_cb = init,
@@ -0,0 +1,102 @@
+// Replaces the global allocation functions to count the allocations and bytes of each thread, for
+// the profiler. Only the app links it in, with EASECURVE_COUNT_ALLOCATIONS, since a replacement
+// applies to the whole program and costs every allocation a thread local increment, profiling or
+// not. A plain translation unit rather than a module unit, since the replacements have to belong to
+// the global module. The aligned forms are left alone, they pair with their own deallocation.
+
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+thread_local std::uint64_t tAllocatedBytes = 0;
+thread_local std::uint64_t tAllocationCount = 0;
+
+// Calls the new handler until the allocation succeeds or there is none, as the replaced forms must.
+void* allocateOrThrow(const std::size_t size)
+{
+    while (true) {
+        if (void* memory = std::malloc(size == 0 ? 1 : size)) {
+            tAllocatedBytes += size;
+            ++tAllocationCount;
+            return memory;
+        }
+        const std::new_handler handler = std::get_new_handler();
+        if (!handler) {
+            throw std::bad_alloc();
+        }
+        handler();
+    }
+}
+
+void* allocateOrNull(const std::size_t size) noexcept
+{
+    try {
+        return allocateOrThrow(size);
+    } catch (const std::bad_alloc&) {
+        return nullptr;
+    }
+}
+
+} // namespace
+
+std::uint64_t countedAllocatedBytes()
+{
+    return tAllocatedBytes;
+}
+
+std::uint64_t countedAllocationCount()
+{
+    return tAllocationCount;
+}
+
+void* operator new(const std::size_t size)
+{
+    return allocateOrThrow(size);
+}
+
+void* operator new[](const std::size_t size)
+{
+    return allocateOrThrow(size);
+}
+
+void* operator new(const std::size_t size, const std::nothrow_t&) noexcept
+{
+    return allocateOrNull(size);
+}
+
+void* operator new[](const std::size_t size, const std::nothrow_t&) noexcept
+{
+    return allocateOrNull(size);
+}
+
+void operator delete(void* memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void* memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void* memory, const std::nothrow_t&) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void* memory, const std::nothrow_t&) noexcept
+{
+    std::free(memory);
+}
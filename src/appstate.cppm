@@ -10,50 +10,97 @@ import sokol.color;
 
 import alx.va;
 
+export import main.frameprofiler;
+export import main.solver;
+import main.triplebuffer;
+import main.workerpool;
+
 using namespace sokol::color;
 namespace va = alx::va;
 
-using FloatToFloatFunc = float (*)(float);
-struct EaseInOut
+// A solve the UI asks for, or another step of the last one to tessellate. Requests posted while the
+// solver is busy are merged into one.
+export struct SolveRequest
+{
+    SolveInput              input                       = {};
+    bool                    solve                       = true;     // false to only select step
+    bool                    incremental                 = false;    // only [firstEase, lastEase] changed
+    int                     firstEase                   = 0;
+    int                     lastEase                    = 0;
+    int                     step                        = std::numeric_limits<int>::max();  // clamped to the steps solved
+};
+
+// One easing variant as the UI sees it: the error of each step and the selected step, tessellated.
+// The velocities of the steps and the direct solver's system stay with the solver thread.
+export struct SolvedVariant
 {
-    FloatToFloatFunc func;
-    FloatToFloatFunc derivative;
-    FloatToFloatFunc antideriv;
+    std::vector<double>     errors                      = {};   // totalErrorAbs of each step
+    Result                  selected                    = {};
+    int                     selectedStep                = -1;
 
-    constexpr float operator()(const float x) const noexcept { return func(x); }
+    [[nodiscard]] int stepCount() const { return static_cast<int>(errors.size()); }
 };
 
-export struct Checkpoint
+// Every easing variant of one path, solved, as the solver thread publishes it.
+export struct SolvedPath
 {
-    float time                 = 0;
-    float progress             = 0;
-    float easeDuration         = 0;
-    float adjustedEaseDuration = 0; // calculated
+    SolveInput              input                       = {};   // what it was solved from
+    std::array<SolvedVariant, kEaseInOutCount> results  = {};   // indexed by EaseInOut
 };
 
-export struct Result
+// Solves off the UI thread. Posted requests are coalesced, so only the newest one waiting gets
+// solved, and the finished results come back through a triple buffer, so neither side blocks.
+export struct SolverThread
 {
-    EaseInOut               easeInOut;
-    std::vector<float>      velocities          = {};
-    std::vector<va::Vec2f>  tessellatedVelocity = {};
-    std::vector<va::Vec2f>  tessellatedProgress = {};
-    std::vector<va::Vec2f>  tessellatedAccel    = {};
-    double                  totalErrorAbs       = 0.;
+    //! Queue a solve, replacing the one still waiting, if any.
+    void post(SolveRequest request);
+    //! The latest finished solve. Call once per frame; it stays valid until the next call.
+    [[nodiscard]] const SolvedPath& latest() { return _published.front(); }
+
+    // internal (private)
+    void run(std::stop_token stop);
+    void solveRequest(SolveRequest& request);
+    //! Copy what the UI reads of the solve into the back buffer and publish it.
+    void publish();
+
+    std::mutex                      _mutex      = {};
+    std::condition_variable_any     _wakeup     = {};
+    std::optional<SolveRequest>     _pending    = {};
+    // the solver's own state, the base of incremental solves and of selecting other steps
+    SolveInput                      _input      = {};
+    std::array<SolveHistory, kEaseInOutCount> _histories = {};     // indexed by EaseInOut
+    int                             _step       = 0;    // selected in both histories, as requested
+    TripleBuffer<SolvedPath>        _published  = {};
+    WorkerPool                      _pool       = {};   // solves the variants in parallel
+    std::jthread                    _thread     = {};   // last, started by the first post
 };
 
-export struct Path
+// Draws the tessellated curves from vertex buffers that stay on the GPU. The data to clip space
+// transform is a uniform, so panning, resizing or changing the borders uploads nothing, and the
+// vertices are uploaded again only when the tessellation they came from changes.
+export struct CurveRenderer
 {
-    float                   startTime                   = 0;
-    float                   startProgress               = 0;
-    float                   startVelocity               = 0;
-    float                   startEaseDuration           = 0;
-    float                   endTime                     = 0;
-    float                   endProgress                 = 0;
-    float                   endVelocity                 = 0;
-    float                   endEaseDuration             = 0;
-    std::vector<Checkpoint> checkpoints                 = {};
-    float                   adjustedStartEaseDuration   = 0;    // calculated
-    float                   adjustedEndEaseDuration     = 0;    // calculated
+    static constexpr size_t kCurveCount = 3;    // progress, velocity, accel
+
+    //! Create the shader and pipeline. Call after sg_setup(). On failure error says why.
+    [[nodiscard]] bool setup(std::string& error);
+    //! Release everything. Call before sg_shutdown().
+    void shutdown();
+    //! Draw the shown curves of result inside the current pass, uploading them first if needed.
+    DrawCounters draw(const Result& result, std::span<const float, 4> transform, std::span<const sg_color, kCurveCount> colors, std::span<const bool, kCurveCount> shown);
+
+    // internal (private)
+    struct Curve
+    {
+        sg_buffer           buffer              = {};
+        size_t              capacity            = 0;    // in points
+        size_t              count               = 0;
+    };
+
+    sg_shader                               _shader         = {};
+    sg_pipeline                             _pipeline       = {};
+    std::array<Curve, kCurveCount>          _curves         = {};
+    std::uint64_t                           _revision       = 0;    // of the uploaded tessellation
 };
 
 export struct AppState
@@ -71,9 +118,8 @@ export struct AppState
     //std::vector<CurveData>  _curves;
 
     Path                    _path               = {};
-    std::vector<Result>     _resultsLinear      = {};
-    std::vector<Result>     _resultsSine        = {};
-    std::vector<Result>*    _selectedResults    = &_resultsSine;
+    EaseInOut               _selectedEaseInOut  = EaseInOut::Sine;
+    SolverMode              _solverMode         = SolverMode::Direct;
 
     va::Vec2f               _mouse              = {};
 
@@ -88,6 +134,7 @@ export struct AppState
 
     va::Vec2i               _border             = {{{ 50, 50 }}};
     int                     _selectedResult     = 0;
+    float                   _tessellationTolerance = 1e-4f; // fraction of the progress span
     int                     _selectedCurve      = -1;
     //bool                    _showCircles        = true;
     bool                    _useSineEasing      = true;
@@ -96,13 +143,25 @@ export struct AppState
     bool                    _showGuides         = true;
     bool                    _showPolyLine       = false;
     bool                    _keepAspectRatio    = false;
-};
+    bool                    _retainFullResults  = false;
+    bool                    _showFrameProfile   = false;
+
+    FrameProfiler           _frameProfiler      = {};
+    CurveRenderer           _curveRenderer      = {};
 
-export void solve(AppState& app, std::vector<Result>& results, bool adjustEase);
-export void render(const AppState& app, const Result& result);
-export void alignEaseDurations(Path& path, const int modifiedIndex);
-export void adjustEaseDurationsP(Path& path);
-export void adjustEaseDurations1(Path& path);
-export void adjustEaseDurations2(Path& path);
+    SolverThread            _solver             = {};   // last, so it stops before the rest goes
+};
 
-float progressAt(const Path& path, const Result& result, const float time);
+export SolveInput solveInput(const AppState& app);
+// Post a solve of the current path to the solver thread.
+export void launchSolve(AppState& app, bool adjustEase);
+export void launchSolveIncremental(AppState& app, int firstEase, int lastEase);
+// Post a selection of another step of the last solve, for the solver thread to tessellate.
+export void launchSelectStep(AppState& app, int step);
+// Records the sokol_gp commands of a frame under the curves, and returns how much it
+// recorded.
+export DrawCounters render(const AppState& app);
+// Draws the curves of result on top, after the sokol_gp commands were flushed.
+export DrawCounters renderCurves(AppState& app, const Result& result);
+// Records the sokol_gp commands drawn over the curves, the mouse cursor, in a sokol_gp frame of its own.
+export DrawCounters renderOverlay(const AppState& app);
@@ -3,11 +3,13 @@ module;
 #include "alx/rassert.h"
 #include "alx/trace.h"
 
-module main.appstate;
+module main.solver;
 
 import alx.assert;
 import alx.trig;
 
+import main.profile;
+
 namespace {
 
 [[maybe_unused]]
@@ -28,8 +30,37 @@ float easeInOutSineIntegral(const float t)
     return 0.5f * (t - std::cos(alx::trig::pi_v<float> * (t - .5f)) / alx::trig::pi_v<float>);
 }
 
-[[maybe_unused]]
-constexpr EaseInOut kEaseInOutSine { &easeInOutSine, &easeInOutSineDerivative, &easeInOutSineIntegral };
+// Polynomial approximations of sin and cos on [-pi/2, pi/2], the only range the sine easing needs,
+// so they need no range reduction and vectorize. They stay within 2.5e-7 of the exact values
+// (measured 2.0e-7 for sin and 1.3e-7 for cos), which keeps the sine easing, its derivative and its
+// integral within kLaneEaseMaxError of the scalar std::sin/std::cos versions.
+constexpr float sinHalfPi(const float x)
+{
+    const float x2 = x * x;
+    return x * (1.f + x2 * (-1.f / 6.f + x2 * (1.f / 120.f + x2 * (-1.f / 5040.f + x2 * (1.f / 362880.f + x2 * (-1.f / 39916800.f))))));
+}
+
+constexpr float cosHalfPi(const float x)
+{
+    const float x2 = x * x;
+    return 1.f + x2 * (-1.f / 2.f + x2 * (1.f / 24.f + x2 * (-1.f / 720.f + x2 * (1.f / 40320.f + x2 * (-1.f / 3628800.f + x2 * (1.f / 479001600.f))))));
+}
+
+struct EaseInOutSine
+{
+    static float func(const float t) { return easeInOutSine(t); }
+    static float derivative(const float t) { return easeInOutSineDerivative(t); }
+    static float antideriv(const float t) { return easeInOutSineIntegral(t); }
+
+    // vectorizable versions for the lane kernel, t in [0, 1]
+    static constexpr float laneFunc(const float t) { return 0.5f * (1.f + sinHalfPi(alx::trig::pi_v<float> * (t - 0.5f))); }
+    static constexpr float laneDerivative(const float t) { return 0.5f * alx::trig::pi_v<float> * cosHalfPi(alx::trig::pi_v<float> * (t - 0.5f)); }
+    static constexpr float laneAntideriv(const float t) { return 0.5f * (t - cosHalfPi(alx::trig::pi_v<float> * (t - .5f)) / alx::trig::pi_v<float>); }
+
+    float operator()(const float x) const noexcept { return func(x); }
+};
+
+constexpr EaseInOutSine kEaseInOutSine {};
 
 [[maybe_unused]]
 constexpr float easeInOutLinear(const float t)
@@ -49,60 +80,125 @@ constexpr float easeInOutLinearIntegral(const float t)
     return .5f * t * t;
 }
 
-[[maybe_unused]]
-constexpr EaseInOut kEaseInOutLinear { &easeInOutLinear, &easeInOutLinearDerivative, &easeInOutLinearIntegral };
+struct EaseInOutLinear
+{
+    static constexpr float func(const float t) { return easeInOutLinear(t); }
+    static constexpr float derivative(const float t) { return easeInOutLinearDerivative(t); }
+    static constexpr float antideriv(const float t) { return easeInOutLinearIntegral(t); }
 
-//constexpr EaseInOut kEaseInOut = kEaseInOutLinear;
-//constexpr EaseInOut kEaseInOut = kEaseInOutSine;
+    static constexpr float laneFunc(const float t) { return func(t); }
+    static constexpr float laneDerivative(const float t) { return derivative(t); }
+    static constexpr float laneAntideriv(const float t) { return antideriv(t); }
 
-[[maybe_unused]]
-float velocityAt(const Path& path, const Result& result, const float time)
+    constexpr float operator()(const float x) const noexcept { return func(x); }
+};
+
+constexpr EaseInOutLinear kEaseInOutLinear {};
+
+// Calls func with the easing policy selected at runtime, so everything below it is specialized for
+// that easing.
+template <typename Func>
+decltype(auto) withEaseInOut(const EaseInOut easeInOut, Func&& func)
 {
-    const size_t count = result.velocities.size();
-    if (time <= path.startTime) {
-        return path.startVelocity;
+    switch (easeInOut) {
+    case EaseInOut::Linear:
+        return std::forward<Func>(func)(kEaseInOutLinear);
+    case EaseInOut::Sine:
+        break;
     }
+    return std::forward<Func>(func)(kEaseInOutSine);
+}
 
-    float prevStartTime             = path.startTime;
-    float prevEaseDuration          = path.adjustedStartEaseDuration;
-    float prevVelocity              = path.startVelocity;
+// Index of the segment containing the time, for times inside the table.
+size_t findSegment(const SegmentTable& segments, const float time)
+{
+    const auto it = std::upper_bound(segments.times.begin(), segments.times.end(), time);
+    return std::min(static_cast<size_t>(it - segments.times.begin()), segments.times.size() - 1) - 1;
+}
 
-    for (size_t k = 0; k < count; ++k) {
-        const bool beforeLast               = k < count - 1;
-        const float curEaseDuration         = beforeLast ? path.checkpoints[k].adjustedEaseDuration : path.adjustedEndEaseDuration;
-        const float curTime                 = beforeLast ? path.checkpoints[k].time - curEaseDuration / 2.f : path.endTime - curEaseDuration;
-        const float curVelocity             = result.velocities[k];
+// Moves the index forward to the segment containing the time, for sweeps over increasing times.
+size_t advanceSegment(const SegmentTable& segments, size_t index, const float time)
+{
+    const size_t lastIndex = segments.times.size() - 2;
+    while (index < lastIndex && segments.times[index + 1] <= time) {
+        ++index;
+    }
+    return index;
+}
 
-        // transition before constant velocity
-        if (time < prevStartTime + prevEaseDuration) {
-            return std::lerp(prevVelocity, curVelocity, result.easeInOut((time - prevStartTime) / prevEaseDuration));
-        }
-        // constant velocity
-        if (time < curTime) {
-            return curVelocity;
-        }
-        prevStartTime           = curTime;
-        prevEaseDuration        = curEaseDuration;
-        prevVelocity            = curVelocity;
+template <typename Ease>
+float segmentProgress(const Ease& easeInOut, const SegmentTable& segments, const size_t index, const float time)
+{
+    const float elapsed     = time - segments.times[index];
+    const float duration    = segments.times[index + 1] - segments.times[index];
+    const float velocity    = segments.velocities[index];
+    return segments.progress[index] + elapsed * velocity + easeInOut.antideriv(elapsed / duration) * duration * (segments.velocities[index + 1] - velocity);
+}
+
+template <typename Ease>
+float segmentVelocity(const Ease& easeInOut, const SegmentTable& segments, const size_t index, const float time)
+{
+    const float duration    = segments.times[index + 1] - segments.times[index];
+    return std::lerp(segments.velocities[index], segments.velocities[index + 1], easeInOut((time - segments.times[index]) / duration));
+}
+
+template <typename Ease>
+float segmentAccel(const Ease& easeInOut, const SegmentTable& segments, const size_t index, const float time)
+{
+    const float duration    = segments.times[index + 1] - segments.times[index];
+    return easeInOut.derivative((time - segments.times[index]) / duration) * (segments.velocities[index + 1] - segments.velocities[index]) / duration;
+}
+
+[[maybe_unused]]
+float velocityAt(const Path& path, const Result& result, const float time)
+{
+    const SegmentTable& segments = result.segments;
+    if (time <= path.startTime) {
+        return path.startVelocity;
     }
-    if (time < prevStartTime + prevEaseDuration) {
-        return std::lerp(prevVelocity, path.endVelocity, result.easeInOut((time - prevStartTime) / prevEaseDuration));
+    if (time >= segments.times.back()) {
+        return path.endVelocity;
     }
-
-    return path.endVelocity;
+    return withEaseInOut(result.easeInOut, [&](const auto& easeInOut) { return segmentVelocity(easeInOut, segments, findSegment(segments, time), time); });
 }
 
 [[maybe_unused]]
 float accelAt(const Path& path, const Result& result, const float time)
 {
-    const size_t count = result.velocities.size();
-    if (time <= path.startTime) {
-        return 0;
+    const SegmentTable& segments = result.segments;
+    if (time <= path.startTime || time >= segments.times.back()) {
+        return 0.f;
     }
+    return withEaseInOut(result.easeInOut, [&](const auto& easeInOut) { return segmentAccel(easeInOut, segments, findSegment(segments, time), time); });
+}
+
+template <typename Ease>
+void buildSegments(const Path& path, const Ease& easeInOut, Result& result)
+{
+    SegmentTable& segments = result.segments;
+    segments.times.clear();
+    segments.progress.clear();
+    segments.velocities.clear();
+
+    segments.times.push_back(path.startTime);
+    segments.progress.push_back(path.startProgress);
+    segments.velocities.push_back(path.startVelocity);
+
+    // Ends the current segment at the given time and velocity. Eases that were adjusted down to
+    // nothing still get a breakpoint, so the velocity steps without easing into the next segment.
+    const float antideriv1 = easeInOut.antideriv(1.f);
+    auto addBreakpoint = [&segments, antideriv1](const float time, const float velocity) {
+        const float prevTime        = segments.times.back();
+        const float prevVelocity    = segments.velocities.back();
+        const float duration        = std::max(0.f, time - prevTime);
+        segments.times.push_back(prevTime + duration);
+        segments.progress.push_back(segments.progress.back() + duration * prevVelocity + antideriv1 * duration * (velocity - prevVelocity));
+        segments.velocities.push_back(velocity);
+    };
 
+    const size_t count = result.velocities.size();
     float prevStartTime     = path.startTime;
     float prevEaseDuration  = path.adjustedStartEaseDuration;
-    float prevVelocity      = path.startVelocity;
 
     for (size_t k = 0; k < count; ++k) {
         const bool beforeLast       = k < count - 1;
@@ -111,64 +207,216 @@ float accelAt(const Path& path, const Result& result, const float time)
         const float curVelocity     = result.velocities[k];
 
         // transition before constant velocity
-        if (time < prevStartTime + prevEaseDuration) {
-            return result.easeInOut.derivative((time - prevStartTime) / prevEaseDuration) * (curVelocity - prevVelocity) / prevEaseDuration;
-        }
+        addBreakpoint(prevStartTime + prevEaseDuration, curVelocity);
         // constant velocity
-        if (time < curTime) {
-            return 0.f;
-        }
+        addBreakpoint(curTime, curVelocity);
+
         prevStartTime       = curTime;
         prevEaseDuration    = curEaseDuration;
-        prevVelocity        = curVelocity;
     }
-    if (time < prevStartTime + prevEaseDuration) {
-        return result.easeInOut.derivative((time - prevStartTime) / prevEaseDuration) * (path.endVelocity - prevVelocity) / prevEaseDuration;
+    // transition to end velocity
+    addBreakpoint(prevStartTime + prevEaseDuration, path.endVelocity);
+}
+
+struct CurvePoint
+{
+    float fraction;
+    float time;
+    float progress;
+    float velocity;
+    float accel;
+};
+
+template <typename Ease>
+CurvePoint sampleSegment(const Ease& easeInOut, const SegmentTable& segments, const size_t index, const float fraction, const float time)
+{
+    const float duration        = segments.times[index + 1] - segments.times[index];
+    const float elapsed         = fraction * duration;
+    const float startVelocity   = segments.velocities[index];
+    const float deltaVelocity   = segments.velocities[index + 1] - startVelocity;
+    return {
+        .fraction   = fraction,
+        .time       = time,
+        .progress   = segments.progress[index] + elapsed * startVelocity + easeInOut.antideriv(fraction) * duration * deltaVelocity,
+        .velocity   = startVelocity + easeInOut(fraction) * deltaVelocity,
+        .accel      = easeInOut.derivative(fraction) * deltaVelocity / duration,
+    };
+}
+
+// Appends a point unless it repeats the last one. Points at the same time only survive where the
+// curve is discontinuous by more than the tolerance, like the acceleration at the ease boundaries.
+void appendCurvePoint(std::vector<va::Vec2f>& curve, const float time, const float value, const float tolerance)
+{
+    if (!curve.empty() && curve.back().x() == time && std::abs(curve.back().y() - value) <= tolerance) {
+        return;
     }
+    curve.push_back({{time, value}});
+}
 
-    return 0.f;
+void appendCurvePoint(Result& result, const CurvePoint& point, const float tolerance)
+{
+    appendCurvePoint(result.tessellatedProgress, point.time, point.progress, tolerance);
+    appendCurvePoint(result.tessellatedVelocity, point.time, point.velocity, tolerance);
+    appendCurvePoint(result.tessellatedAccel, point.time, point.accel, tolerance);
 }
 
-void tessellateVelocity(AppState& app, Result& result)
+// Every ease is split at least into 1 << kMinSubdivisionDepth pieces, so the symmetry of the sine
+// easing can't hide the error from the midpoint test, and at most into 1 << kMaxSubdivisionDepth.
+constexpr int kMinSubdivisionDepth = 2;
+constexpr int kMaxSubdivisionDepth = 12;
+
+// Appends the points after start up to and including end, halving the interval until the midpoint
+// of every channel is within the tolerance of the chord.
+template <typename Ease>
+void subdivideSegment(const Ease& easeInOut, const SegmentTable& segments, const size_t index, const CurvePoint& start, const CurvePoint& end, const int depth, const float tolerance, Result& result)
 {
-    constexpr int linesPerSegment = 1000;
-    result.tessellatedVelocity.clear();
-    result.tessellatedVelocity.resize(linesPerSegment + 1);
-    const float xIncrement = (app._path.endTime - app._path.startTime) / linesPerSegment;
-    for (size_t i = 0; i <= linesPerSegment; ++i) {
-        const float x = app._path.startTime + i * xIncrement;
-        const float y = velocityAt(app._path, result, x);
-        result.tessellatedVelocity[i] = {{x, y}};
+    const float fraction = (start.fraction + end.fraction) / 2.f;
+    const CurvePoint mid = sampleSegment(easeInOut, segments, index, fraction, (start.time + end.time) / 2.f);
+    const float error = std::max({
+        std::abs(mid.progress - (start.progress + end.progress) / 2.f),
+        std::abs(mid.velocity - (start.velocity + end.velocity) / 2.f),
+        std::abs(mid.accel - (start.accel + end.accel) / 2.f),
+    });
+    if (depth < kMaxSubdivisionDepth && (depth < kMinSubdivisionDepth || error > tolerance)) {
+        subdivideSegment(easeInOut, segments, index, start, mid, depth + 1, tolerance, result);
+        subdivideSegment(easeInOut, segments, index, mid, end, depth + 1, tolerance, result);
+    } else {
+        appendCurvePoint(result, end, tolerance);
     }
 }
 
-void tessellateProgress(AppState& app, Result& result)
+// Emits the exact end points of every segment, nothing in between for constant velocity segments,
+// and as many points as the tolerance requires for the eases. Appends segments [first, last) to the
+// curves of result and records where the points of each of them start.
+template <typename Ease>
+void tessellateSegments(const Ease& easeInOut, const SegmentTable& segments, const size_t first, const size_t last, const float tolerance, Result& result)
 {
-    constexpr size_t linesPerSegment = 1000;
-    const float xIncrement = (app._path.endTime - app._path.startTime) / linesPerSegment;
-    result.tessellatedProgress.clear();
-    result.tessellatedProgress.resize(linesPerSegment + 1);
-    for (size_t i = 0; i <= linesPerSegment; ++i) {
-        const float x = app._path.startTime + i * xIncrement;
-        const float y = progressAt(app._path, result, x);
-        result.tessellatedProgress[i] = {{x, y}};
+    for (size_t index = first; index < last; ++index) {
+        result.tessellatedRuns.push_back({ result.tessellatedProgress.size(), result.tessellatedVelocity.size(), result.tessellatedAccel.size() });
+        if (segments.times[index + 1] <= segments.times[index]) {
+            continue;
+        }
+        const CurvePoint start = sampleSegment(easeInOut, segments, index, 0.f, segments.times[index]);
+        const CurvePoint end = sampleSegment(easeInOut, segments, index, 1.f, segments.times[index + 1]);
+        appendCurvePoint(result, start, tolerance);
+        if (segments.velocities[index] == segments.velocities[index + 1]) {
+            appendCurvePoint(result, end, tolerance);
+        } else {
+            subdivideSegment(easeInOut, segments, index, start, end, 0, tolerance, result);
+        }
     }
 }
 
-void tessellateAcceleration(AppState& app, Result& result)
+// Unique across all results, so a cache of one tessellation never mistakes another for it.
+std::uint64_t nextRevision()
 {
-    constexpr size_t linesPerSegment = 1000;
+    static std::atomic<std::uint64_t> revision = 0;
+    return revision.fetch_add(1, std::memory_order_relaxed) + 1;
+}
+
+// Replaces the points [begin, end) of curve with the points of patch after its seed points.
+void spliceCurve(std::vector<va::Vec2f>& curve, const size_t begin, const size_t end, const std::vector<va::Vec2f>& patch, const size_t seed)
+{
+    const auto at = curve.begin() + static_cast<std::ptrdiff_t>(begin);
+    curve.erase(at, curve.begin() + static_cast<std::ptrdiff_t>(end));
+    curve.insert(curve.begin() + static_cast<std::ptrdiff_t>(begin), patch.begin() + static_cast<std::ptrdiff_t>(seed), patch.end());
+}
+
+// Re-tessellates segments [first, last) of an already tessellated result in place. The patch starts
+// from the point before the first segment, so deduplication continues across the seam; the caller
+// includes one unchanged segment after the changed ones for the same reason at the other end.
+template <typename Ease>
+void retessellateSegments(const Ease& easeInOut, const size_t first, const size_t last, const float tolerance, Result& result)
+{
+    std::array<std::vector<va::Vec2f>*, 3> curves = { &result.tessellatedProgress, &result.tessellatedVelocity, &result.tessellatedAccel };
+    const std::array<size_t, 3> begin = result.tessellatedRuns[first];
+    const std::array<size_t, 3> end = last < result.tessellatedRuns.size() ? result.tessellatedRuns[last] : std::array<size_t, 3> { curves[0]->size(), curves[1]->size(), curves[2]->size() };
+
+    Result patch;
+    std::array<std::vector<va::Vec2f>*, 3> patchCurves = { &patch.tessellatedProgress, &patch.tessellatedVelocity, &patch.tessellatedAccel };
+    std::array<size_t, 3> seed = {};
+    for (size_t channel = 0; channel < 3; ++channel) {
+        if (begin[channel] > 0) {
+            patchCurves[channel]->push_back((*curves[channel])[begin[channel] - 1]);
+            seed[channel] = 1;
+        }
+    }
+    tessellateSegments(easeInOut, result.segments, first, last, tolerance, patch);
+
+    for (size_t channel = 0; channel < 3; ++channel) {
+        spliceCurve(*curves[channel], begin[channel], end[channel], *patchCurves[channel], seed[channel]);
+        const size_t newEnd = begin[channel] + patchCurves[channel]->size() - seed[channel];
+        for (size_t index = first; index < last; ++index) {
+            result.tessellatedRuns[index][channel] = begin[channel] + patch.tessellatedRuns[index - first][channel] - seed[channel];
+        }
+        for (size_t index = last; index < result.tessellatedRuns.size(); ++index) {
+            result.tessellatedRuns[index][channel] = result.tessellatedRuns[index][channel] - end[channel] + newEnd;
+        }
+    }
+    result.revision = nextRevision();
+}
+
+template <typename Ease>
+void tessellateAll(const Ease& easeInOut, const float tolerance, Result& result)
+{
+    result.tessellatedProgress.clear();
+    result.tessellatedVelocity.clear();
     result.tessellatedAccel.clear();
-    result.tessellatedAccel.resize(linesPerSegment + 1);
-    const float xIncrement = (app._path.endTime - app._path.startTime) / linesPerSegment;
-    for (size_t i = 1; i <= linesPerSegment; ++i) {
-        const float x = app._path.startTime + i * xIncrement;
-        const float y = accelAt(app._path, result, x);
-        result.tessellatedAccel[i] = {{x, y}};
+    result.tessellatedRuns.clear();
+    tessellateSegments(easeInOut, result.segments, 0, result.segments.times.size() - 1, tolerance, result);
+    result.revision = nextRevision();
+}
+
+size_t tessellatedPoints(const Result& result)
+{
+    return result.tessellatedProgress.size() + result.tessellatedVelocity.size() + result.tessellatedAccel.size();
+}
+
+void tessellate(const Path& path, const float tolerance, Result& result)
+{
+    const ProfileScope scope("tessellate", Metric::TessellateTime);
+    withEaseInOut(result.easeInOut, [&](const auto& easeInOut) {
+        buildSegments(path, easeInOut, result);
+        tessellateAll(easeInOut, tolerance, result);
+    });
+    profileSample(Metric::PointsEmitted, static_cast<float>(tessellatedPoints(result)));
+}
+
+// Breakpoint progress accumulates rounding along the whole path, so a re-solve moves it slightly
+// even where nothing changed. Moves below this fraction of the tolerance don't count as changes.
+constexpr float kRetessellateSlack = 1e-2f;
+
+// Rebuilds the segments of a re-solved result and re-tessellates only the ones that moved.
+template <typename Ease>
+void retessellate(const Path& path, const Ease& easeInOut, const float tolerance, Result& result)
+{
+    const SegmentTable previous = std::move(result.segments);
+    buildSegments(path, easeInOut, result);
+
+    const SegmentTable& segments = result.segments;
+    const size_t count = segments.times.size();
+    if (previous.times.size() != count || result.tessellatedRuns.size() + 1 != count) {
+        tessellateAll(easeInOut, tolerance, result);
+        return;
+    }
+    size_t firstChanged = count;
+    size_t lastChanged = 0;
+    for (size_t index = 0; index < count; ++index) {
+        if (segments.times[index] != previous.times[index]
+            || segments.velocities[index] != previous.velocities[index]
+            || std::abs(segments.progress[index] - previous.progress[index]) > tolerance * kRetessellateSlack) {
+            firstChanged = std::min(firstChanged, index);
+            lastChanged = index;
+        }
+    }
+    if (firstChanged == count) {
+        return;
     }
+    // a breakpoint ends one segment and starts the next
+    retessellateSegments(easeInOut, firstChanged > 0 ? firstChanged - 1 : 0, std::min(lastChanged + 2, count - 1), tolerance, result);
 }
 
-void seedInitialVelocities(Path& path, Result& result)
+void seedInitialVelocities(const Path& path, Result& result)
 {
     {
         float prevTime         = path.startTime;
@@ -209,20 +457,25 @@ void seedInitialVelocities(Path& path, Result& result)
     }
 };
 
-[[maybe_unused]]
-float refineVelocities(Path& path, Result& result)
+struct ProgressError
 {
-    const size_t count = result.velocities.size();
+    float sumErrorAbs                   = 0;
+    float largestError                  = 0;
+    float largestErrorAbs               = 0;
+    size_t largestErrorIndex            = 0;
+    float largestErrorSegmentDuration   = 0;
+};
+
+template <typename Ease>
+ProgressError measureProgressError(const Path& path, const Ease& easeInOut, const std::span<const float> velocities)
+{
+    const size_t count = velocities.size();
 
-    float sumErrorAbs                       = 0;
-    float largestError                      = 0;
-    float largestErrorAbs                   = 0;
-    size_t largestErrorIndex                = 0;
-    float largestErrorSegmentDuration       = 0;
+    ProgressError error;
 
     float progress = path.startProgress;
     // initial transition before constant velocity
-    progress += path.adjustedStartEaseDuration * path.startVelocity + result.easeInOut.antideriv(1.f) * path.adjustedStartEaseDuration * (result.velocities[0] - path.startVelocity);
+    progress += path.adjustedStartEaseDuration * path.startVelocity + easeInOut.antideriv(1.f) * path.adjustedStartEaseDuration * (velocities[0] - path.startVelocity);
 
     float prevStartTime             = path.startTime;
     float prevEaseDuration          = path.adjustedStartEaseDuration;
@@ -232,81 +485,436 @@ float refineVelocities(Path& path, Result& result)
         const float curEaseDurationTotal    = beforeLast ? path.checkpoints[k].adjustedEaseDuration : path.adjustedEndEaseDuration;
         const float curEaseDurationFraction = beforeLast ? .5f : 1.f;
         const float curEaseDuration         = curEaseDurationTotal * curEaseDurationFraction;
-        const float curVelocity             = result.velocities[k];
-        const float nextVelocity            = beforeLast ? result.velocities[k + 1] : path.endVelocity;
+        const float curVelocity             = velocities[k];
+        const float nextVelocity            = beforeLast ? velocities[k + 1] : path.endVelocity;
         const float checkPointTime          = beforeLast ? path.checkpoints[k].time : path.endTime;
         const float checkPointProgress      = beforeLast ? path.checkpoints[k].progress : path.endProgress;
 
         // constant velocity
         progress += curVelocity * (checkPointTime - prevStartTime - prevEaseDuration - curEaseDuration);
         // checkpoint
-        const float calculatedProgress      = progress + curEaseDuration * curVelocity + result.easeInOut.antideriv(curEaseDurationFraction) * curEaseDurationTotal * (nextVelocity - curVelocity);
+        const float calculatedProgress      = progress + curEaseDuration * curVelocity + easeInOut.antideriv(curEaseDurationFraction) * curEaseDurationTotal * (nextVelocity - curVelocity);
         const float progressError           = checkPointProgress - calculatedProgress;
         const float progressErrorAbs        = std::abs(progressError);
-        if (progressErrorAbs > largestErrorAbs) {
-            largestError                    = progressError;
-            largestErrorAbs                 = progressErrorAbs;
-            largestErrorIndex               = k;
-            largestErrorSegmentDuration     = checkPointTime - prevStartTime;
+        if (progressErrorAbs > error.largestErrorAbs) {
+            error.largestError                  = progressError;
+            error.largestErrorAbs               = progressErrorAbs;
+            error.largestErrorIndex             = k;
+            error.largestErrorSegmentDuration   = checkPointTime - prevStartTime;
         }
 
-        sumErrorAbs                         += progressErrorAbs;
+        error.sumErrorAbs                   += progressErrorAbs;
 
         // transition after constant velocity
-        progress += curEaseDurationTotal * curVelocity + result.easeInOut.antideriv(1.f) * curEaseDurationTotal * (nextVelocity - curVelocity);
+        progress += curEaseDurationTotal * curVelocity + easeInOut.antideriv(1.f) * curEaseDurationTotal * (nextVelocity - curVelocity);
 
         prevStartTime           = checkPointTime;
         prevEaseDuration        = curEaseDuration;
     }
 
-    result.velocities[largestErrorIndex]      += largestError / largestErrorSegmentDuration;
-    result.totalErrorAbs = static_cast<double>(sumErrorAbs);
-    return sumErrorAbs;
+    return error;
 }
 
-} // namespace
+template <typename Ease>
+float refineVelocities(const Path& path, const Ease& easeInOut, Result& result)
+{
+    const ProgressError error = measureProgressError(path, easeInOut, result.velocities);
 
-[[maybe_unused]]
-float progressAt(const Path& path, const Result& result, const float time)
+    result.velocities[error.largestErrorIndex]  += error.largestError / error.largestErrorSegmentDuration;
+    result.totalErrorAbs = static_cast<double>(error.sumErrorAbs);
+    return error.sumErrorAbs;
+}
+
+// Refines the largest error checkpoint until the error settles, calling onStep() after each refinement.
+template <typename Ease, typename OnStep>
+float solveVelocitiesIterative(const Path& path, const Ease& easeInOut, Result& result, const OnStep& onStep)
 {
-    const size_t count = result.velocities.size();
-    float progress = path.startProgress;
-    if (time <= path.startTime) {
-        return progress;
+    float prevError = 0;
+    if (result.velocities.size() > 1) {
+        while (true) {
+            const float error = refineVelocities(path, easeInOut, result);
+            onStep();
+            const float errDelta = std::abs(error - prevError);
+            //std::println("Error delta: {}", errDelta);
+            if (errDelta <= 1e-5f) {
+                break;
+            }
+            prevError = error;
+        }
     }
+    return prevError;
+}
 
-    float prevStartTime     = path.startTime;
-    float prevEaseDuration  = path.adjustedStartEaseDuration;
-    float prevVelocity      = path.startVelocity;
+// The ease around a checkpoint and the fraction of it that lies before the checkpoint. Index 0 is
+// the start ease, which lies entirely after the start time, so it behaves like a checkpoint ease
+// with a fraction of 0; index checkpoints.size() + 1 is the end ease, with a fraction of 1.
+struct EaseWindow
+{
+    float time;
+    float progress;
+    float durationTotal;
+    float durationFraction;
+};
 
+EaseWindow easeWindow(const Path& path, const size_t index)
+{
+    if (index == 0) {
+        return { path.startTime, path.startProgress, path.adjustedStartEaseDuration, 0.f };
+    }
+    if (index > path.checkpoints.size()) {
+        return { path.endTime, path.endProgress, path.adjustedEndEaseDuration, 1.f };
+    }
+    const Checkpoint& checkpoint = path.checkpoints[index - 1];
+    return { checkpoint.time, checkpoint.progress, checkpoint.adjustedEaseDuration, .5f };
+}
+
+// With the adjusted ease durations fixed, the progress reached at every checkpoint is linear in the
+// velocities. The progress gained between two consecutive checkpoints only depends on the velocity
+// before, at and after the later one, so the velocities are the solution of a tridiagonal system:
+//
+//     lower[k] * v[k-1] + diag[k] * v[k] + upper[k] * v[k+1] = progress[k] - progress[k-1]
+//
+// with v[-1] = startVelocity and v[count] = endVelocity. It is solved in O(N) with the Thomas
+// algorithm, in double precision to keep long paths stable. Row k only reads the eases around
+// checkpoints k - 1 and k.
+template <typename Ease>
+void buildVelocityRow(const Path& path, const Ease& easeInOut, const size_t k, VelocitySystem& system)
+{
+    const size_t count = system.diag.size();
+    const float antideriv1 = easeInOut.antideriv(1.f);
+    const EaseWindow prev = easeWindow(path, k);
+    const EaseWindow cur = easeWindow(path, k + 1);
+    const float curEaseDuration = cur.durationTotal * cur.durationFraction;
+
+    // the part of the previous ease that lies after the previous checkpoint
+    const double prevTailDuration   = static_cast<double>(prev.durationTotal * (1.f - prev.durationFraction));
+    const double prevTailAntideriv  = static_cast<double>((antideriv1 - easeInOut.antideriv(prev.durationFraction)) * prev.durationTotal);
+    // the part of the current ease that lies before the checkpoint
+    const double curHeadAntideriv   = static_cast<double>(easeInOut.antideriv(cur.durationFraction) * cur.durationTotal);
+    // constant velocity in between
+    const double cruiseDuration     = static_cast<double>(cur.time - prev.time) - prevTailDuration - static_cast<double>(curEaseDuration);
+
+    system.lower[k] = prevTailDuration - prevTailAntideriv;
+    system.diag[k]  = prevTailAntideriv + cruiseDuration + static_cast<double>(curEaseDuration) - curHeadAntideriv;
+    system.upper[k] = curHeadAntideriv;
+    system.rhs[k]   = static_cast<double>(cur.progress - prev.progress);
+
+    // move the known start and end velocities to the right hand side
+    if (k == 0) {
+        system.rhs[k]   -= system.lower[k] * static_cast<double>(path.startVelocity);
+        system.lower[k] = 0.;
+    }
+    if (k == count - 1) {
+        system.rhs[k]   -= system.upper[k] * static_cast<double>(path.endVelocity);
+        system.upper[k] = 0.;
+    }
+}
+
+// Extends the forward elimination up to row end.
+void eliminateForward(VelocitySystem& system, const size_t end)
+{
+    for (size_t k = system.forwardValid; k < end; ++k) {
+        const double prevUpper  = k > 0 ? system.forwardUpper[k - 1] : 0.;
+        const double prevRhs    = k > 0 ? system.forwardRhs[k - 1] : 0.;
+        const double pivot      = system.diag[k] - system.lower[k] * prevUpper;
+        system.forwardUpper[k]  = system.upper[k] / pivot;
+        system.forwardRhs[k]    = (system.rhs[k] - system.lower[k] * prevRhs) / pivot;
+    }
+    system.forwardValid = std::max(system.forwardValid, end);
+}
+
+// Extends the backward elimination down to row begin.
+void eliminateBackward(VelocitySystem& system, const size_t begin)
+{
+    const size_t count = system.diag.size();
+    for (size_t k = system.backwardValid; k-- > begin;) {
+        const double nextLower  = k + 1 < count ? system.backwardLower[k + 1] : 0.;
+        const double nextRhs    = k + 1 < count ? system.backwardRhs[k + 1] : 0.;
+        const double pivot      = system.diag[k] - system.upper[k] * nextLower;
+        system.backwardLower[k] = system.lower[k] / pivot;
+        system.backwardRhs[k]   = (system.rhs[k] - system.upper[k] * nextRhs) / pivot;
+    }
+    system.backwardValid = std::min(system.backwardValid, begin);
+}
+
+template <typename Ease>
+float solveVelocitiesDirect(const Path& path, const Ease& easeInOut, VelocitySystem& system, Result& result)
+{
+    const size_t count = path.checkpoints.size() + 1;
+    for (std::vector<double>* row : { &system.lower, &system.diag, &system.upper, &system.rhs, &system.forwardUpper, &system.forwardRhs, &system.backwardLower, &system.backwardRhs, &system.solution }) {
+        row->assign(count, 0.);
+    }
     for (size_t k = 0; k < count; ++k) {
-        const bool beforeLast       = k < count - 1;
-        const float curEaseDuration = beforeLast ? path.checkpoints[k].adjustedEaseDuration : path.adjustedEndEaseDuration;
-        const float curTime         = beforeLast ? path.checkpoints[k].time - curEaseDuration / 2.f : path.endTime - curEaseDuration;
-        const float curVelocity     = result.velocities[k];
+        buildVelocityRow(path, easeInOut, k, system);
+    }
+    // the backward elimination is only built when an incremental solve needs it
+    system.forwardValid     = 0;
+    system.backwardValid    = count;
+    eliminateForward(system, count);
+
+    // back substitution
+    result.velocities.resize(count);
+    double nextVelocity = 0.;
+    for (size_t k = count; k-- > 0;) {
+        nextVelocity = system.forwardRhs[k] - system.forwardUpper[k] * nextVelocity;
+        system.solution[k] = nextVelocity;
+        result.velocities[k] = static_cast<float>(nextVelocity);
+    }
 
-        // transition before constant velocity
-        if (time < prevStartTime + prevEaseDuration) {
-            return progress + (time - prevStartTime) * prevVelocity + result.easeInOut.antideriv((time - prevStartTime) / prevEaseDuration) * prevEaseDuration * (curVelocity - prevVelocity);
+    const ProgressError error = measureProgressError(path, easeInOut, result.velocities);
+    result.totalErrorAbs = static_cast<double>(error.sumErrorAbs);
+    return error.sumErrorAbs;
+}
+
+// Relative velocity change below which the incremental solve considers the change to have died out,
+// far below the float precision the velocities are stored in.
+constexpr double kSettledVelocity = 1e-12;
+
+// Re-solves the system after rows [firstRow, lastRow] were rebuilt. The forward elimination is
+// current before firstRow and the backward one after lastRow, since neither reads the rebuilt rows,
+// so only the rebuilt rows are eliminated again and the two meet at lastRow. From there the
+// velocities are substituted outwards until they stop changing. Returns the range of changed
+// velocities.
+std::pair<size_t, size_t> resolveVelocityRows(VelocitySystem& system, const size_t firstRow, const size_t lastRow)
+{
+    const size_t count = system.diag.size();
+    std::vector<double>& solution = system.solution;
+    auto settled = [](const double velocity, const double previous) { return std::abs(velocity - previous) <= kSettledVelocity * std::abs(previous); };
+
+    system.forwardValid = std::min(system.forwardValid, firstRow);
+    eliminateForward(system, lastRow + 1);
+    system.backwardValid = std::max(system.backwardValid, lastRow + 1);
+    eliminateBackward(system, lastRow + 1);
+
+    if (lastRow + 1 == count) {
+        solution[lastRow] = system.forwardRhs[lastRow];
+    } else {
+        solution[lastRow] = (system.forwardRhs[lastRow] - system.forwardUpper[lastRow] * system.backwardRhs[lastRow + 1])
+                          / (1. - system.forwardUpper[lastRow] * system.backwardLower[lastRow + 1]);
+    }
+    size_t last = lastRow + 1;
+    for (; last < count; ++last) {
+        const double velocity = system.backwardRhs[last] - system.backwardLower[last] * solution[last - 1];
+        if (settled(velocity, solution[last])) {
+            break;
         }
-        progress += prevEaseDuration * prevVelocity + result.easeInOut.antideriv(1.f) * prevEaseDuration * (curVelocity - prevVelocity);
-        // constant velocity
-        if (time < curTime) {
-            return progress + curVelocity * (time - prevStartTime - prevEaseDuration);
+        solution[last] = velocity;
+    }
+    size_t first = lastRow;
+    for (; first > 0; --first) {
+        const double velocity = system.forwardRhs[first - 1] - system.forwardUpper[first - 1] * solution[first];
+        if (first - 1 < firstRow && settled(velocity, solution[first - 1])) {
+            break;
         }
-        progress += curVelocity * (curTime - prevStartTime - prevEaseDuration);
+        solution[first - 1] = velocity;
+    }
+    return { first, last };
+}
 
-        prevStartTime       = curTime;
-        prevEaseDuration    = curEaseDuration;
-        prevVelocity        = curVelocity;
+void recordStep(const SolveInput& input, SolveHistory& history, const Result& result)
+{
+    history.velocities.insert(history.velocities.end(), result.velocities.begin(), result.velocities.end());
+    history.errors.push_back(result.totalErrorAbs);
+    if (input.retainFullResults) {
+        tessellate(input.path, input.tessellationTolerance, history.retained.emplace_back(result));
     }
-    // Transition to end velocity
-    if (time < prevStartTime + prevEaseDuration) {
-        return progress + (time - prevStartTime) * prevVelocity + result.easeInOut.antideriv((time - prevStartTime) / prevEaseDuration) * prevEaseDuration * (path.endVelocity - prevVelocity);
+}
+
+template <typename Ease>
+void evaluateSweep(const Path& path, const Ease& easeInOut, const Result& result, const std::span<const float> times, const std::span<float> progress, const std::span<float> velocity, const std::span<float> accel)
+{
+    const SegmentTable& segments = result.segments;
+    const float endTime = segments.times.back();
+    size_t index = 0;
+    for (size_t i = 0; i < times.size(); ++i) {
+        const float time = times[i];
+        if (time <= path.startTime) {
+            progress[i] = path.startProgress;
+            velocity[i] = path.startVelocity;
+            accel[i]    = 0.f;
+        } else if (time >= endTime) {
+            progress[i] = segments.progress.back();
+            velocity[i] = path.endVelocity;
+            accel[i]    = 0.f;
+        } else {
+            index = advanceSegment(segments, index, time);
+            const float elapsed         = time - segments.times[index];
+            const float duration        = segments.times[index + 1] - segments.times[index];
+            const float startVelocity   = segments.velocities[index];
+            const float deltaVelocity   = segments.velocities[index + 1] - startVelocity;
+            const float fraction        = elapsed / duration;
+            progress[i] = segments.progress[index] + elapsed * startVelocity + easeInOut.antideriv(fraction) * duration * deltaVelocity;
+            velocity[i] = startVelocity + easeInOut(fraction) * deltaVelocity;
+            accel[i]    = easeInOut.derivative(fraction) * deltaVelocity / duration;
+        }
     }
-    progress += prevEaseDuration * prevVelocity + result.easeInOut.antideriv(1.f) * prevEaseDuration * (path.endVelocity - prevVelocity);
+}
+
+// Samples per block of the lane kernel, one 256 bit register of floats.
+constexpr size_t kLanes = 8;
+
+// Evaluates blocks of kLanes samples. The segment of each lane is looked up with the same forward
+// sweep as evaluateSweep and gathered into lane arrays, with times outside the path turned into
+// constant segments, so the math runs without branches over full blocks and auto-vectorizes.
+template <typename Ease>
+void evaluateLanes(const Path& path, const Ease& easeInOut, const Result& result, const std::span<const float> times, const std::span<float> progress, const std::span<float> velocity, const std::span<float> accel)
+{
+    const SegmentTable& segments = result.segments;
+    const float endTime = segments.times.back();
+    size_t index = 0;
+    for (size_t block = 0; block < times.size(); block += kLanes) {
+        const size_t lanes = std::min(kLanes, times.size() - block);
+
+        std::array<float, kLanes> elapsed;
+        std::array<float, kLanes> duration;
+        std::array<float, kLanes> startProgress;
+        std::array<float, kLanes> startVelocity;
+        std::array<float, kLanes> deltaVelocity;
+        for (size_t lane = 0; lane < kLanes; ++lane) {
+            // the lanes past the end of a partial block repeat its last time
+            const float time = times[block + std::min(lane, lanes - 1)];
+            if (time <= path.startTime) {
+                elapsed[lane]       = 0.f;
+                duration[lane]      = 1.f;
+                startProgress[lane] = path.startProgress;
+                startVelocity[lane] = path.startVelocity;
+                deltaVelocity[lane] = 0.f;
+            } else if (time >= endTime) {
+                elapsed[lane]       = 0.f;
+                duration[lane]      = 1.f;
+                startProgress[lane] = segments.progress.back();
+                startVelocity[lane] = path.endVelocity;
+                deltaVelocity[lane] = 0.f;
+            } else {
+                index = advanceSegment(segments, index, time);
+                elapsed[lane]       = time - segments.times[index];
+                duration[lane]      = segments.times[index + 1] - segments.times[index];
+                startProgress[lane] = segments.progress[index];
+                startVelocity[lane] = segments.velocities[index];
+                deltaVelocity[lane] = segments.velocities[index + 1] - segments.velocities[index];
+            }
+        }
+
+        std::array<float, kLanes> blockProgress;
+        std::array<float, kLanes> blockVelocity;
+        std::array<float, kLanes> blockAccel;
+        for (size_t lane = 0; lane < kLanes; ++lane) {
+            const float fraction    = elapsed[lane] / duration[lane];
+            blockProgress[lane]     = startProgress[lane] + elapsed[lane] * startVelocity[lane] + easeInOut.laneAntideriv(fraction) * duration[lane] * deltaVelocity[lane];
+            blockVelocity[lane]     = startVelocity[lane] + easeInOut.laneFunc(fraction) * deltaVelocity[lane];
+            blockAccel[lane]        = easeInOut.laneDerivative(fraction) * deltaVelocity[lane] / duration[lane];
+        }
 
-    return progress;
+        std::copy_n(blockProgress.begin(), lanes, progress.subspan(block, lanes).begin());
+        std::copy_n(blockVelocity.begin(), lanes, velocity.subspan(block, lanes).begin());
+        std::copy_n(blockAccel.begin(), lanes, accel.subspan(block, lanes).begin());
+    }
+}
+
+struct BatchContext
+{
+    std::span<Path>             paths;
+    const BatchSettings&        settings;
+    BatchSolution&              solution;
+    WorkerPool&                 pool;
+    std::span<BatchScratch>     scratch;    // one per worker, plus one for the calling thread
+    std::latch                  done;
+};
+
+void solveBatchPath(BatchContext& context, const size_t index)
+{
+    const BatchSettings& settings = context.settings;
+    BatchSolution& solution = context.solution;
+    BatchScratch& scratch = context.scratch[context.pool.currentWorker()];
+
+    Path& path = context.paths[index];
+    if (settings.adjustEase) {
+        adjustEaseDurationsP(path, scratch.easings);
+    }
+
+    Result& result = scratch.result;
+    result.easeInOut = settings.easeInOut;
+    int steps = 1;
+    seedInitialVelocities(path, result);
+    withEaseInOut(settings.easeInOut, [&](const auto& easeInOut) {
+        if (settings.solverMode == SolverMode::Direct) {
+            solveVelocitiesDirect(path, easeInOut, scratch.system, result);
+            ++steps;
+        } else {
+            solveVelocitiesIterative(path, easeInOut, result, [&] { ++steps; });
+            // each refinement reports the error from before its correction
+            result.totalErrorAbs = static_cast<double>(measureProgressError(path, easeInOut, result.velocities).sumErrorAbs);
+        }
+        if (settings.progressSamples > 0) {
+            buildSegments(path, easeInOut, result);
+        }
+    });
+
+    std::ranges::copy(result.velocities, std::span(solution.velocities).subspan(solution.offsets[index]).begin());
+    solution.errors[index] = result.totalErrorAbs;
+    solution.steps[index] = steps;
+    if (settings.tessellate) {
+        Result& tessellated = solution.tessellated[index];
+        tessellated.easeInOut = result.easeInOut;
+        tessellated.velocities.assign(result.velocities.begin(), result.velocities.end());
+        tessellated.totalErrorAbs = result.totalErrorAbs;
+        const float span = std::max(std::abs(path.endProgress - path.startProgress), std::numeric_limits<float>::min());
+        tessellate(path, settings.tessellationTolerance * span, tessellated);
+    }
+    if (const size_t samples = settings.progressSamples; samples > 0) {
+        scratch.times.resize(samples);
+        scratch.velocity.resize(samples);
+        scratch.accel.resize(samples);
+        const float step = samples > 1 ? (path.endTime - path.startTime) / static_cast<float>(samples - 1) : 0.f;
+        for (size_t sample = 0; sample < samples; ++sample) {
+            scratch.times[sample] = path.startTime + step * static_cast<float>(sample);
+        }
+        evaluateBatch(path, result, scratch.times, std::span(solution.progress).subspan(index * samples, samples), scratch.velocity, scratch.accel);
+    }
+    context.done.count_down();
+}
+
+} // namespace
+
+void buildSegments(const Path& path, Result& result)
+{
+    R_ASSERT(result.velocities.size() == path.checkpoints.size() + 1);
+
+    withEaseInOut(result.easeInOut, [&](const auto& easeInOut) { buildSegments(path, easeInOut, result); });
+}
+
+float progressAt(const Path& path, const Result& result, const float time)
+{
+    R_ASSERT(!result.segments.times.empty());
+
+    const SegmentTable& segments = result.segments;
+    if (time <= path.startTime) {
+        return path.startProgress;
+    }
+    if (time >= segments.times.back()) {
+        return segments.progress.back();
+    }
+    return withEaseInOut(result.easeInOut, [&](const auto& easeInOut) { return segmentProgress(easeInOut, segments, findSegment(segments, time), time); });
+}
+
+void evaluateBatch(const Path& path, const Result& result, const std::span<const float> times, const std::span<float> progress, const std::span<float> velocity, const std::span<float> accel)
+{
+    R_ASSERT(progress.size() == times.size());
+    R_ASSERT(velocity.size() == times.size());
+    R_ASSERT(accel.size() == times.size());
+    R_ASSERT(!result.segments.times.empty());
+
+    withEaseInOut(result.easeInOut, [&](const auto& easeInOut) { evaluateSweep(path, easeInOut, result, times, progress, velocity, accel); });
+}
+
+void evaluateBatchLanes(const Path& path, const Result& result, const std::span<const float> times, const std::span<float> progress, const std::span<float> velocity, const std::span<float> accel)
+{
+    R_ASSERT(progress.size() == times.size());
+    R_ASSERT(velocity.size() == times.size());
+    R_ASSERT(accel.size() == times.size());
+    R_ASSERT(!result.segments.times.empty());
+
+    withEaseInOut(result.easeInOut, [&](const auto& easeInOut) { evaluateLanes(path, easeInOut, result, times, progress, velocity, accel); });
 }
 
 void adjustEaseDurations1(Path& path)
@@ -555,6 +1163,12 @@ void adjustEaseDurations2(Path& path)
 
 [[maybe_unused]]
 void adjustEaseDurationsP(Path& path)
+{
+    std::vector<float> newEasings;
+    adjustEaseDurationsP(path, newEasings);
+}
+
+void adjustEaseDurationsP(Path& path, std::vector<float>& newEasings)
 {
     // Optimizing algorithm that tries to balance the easings of checkpoints so that they don't
     // overlap. We iterate front to back, and find the easing necessary for each checkpoint to fit
@@ -567,7 +1181,6 @@ void adjustEaseDurationsP(Path& path)
     constexpr float errorTarget = 0.0001f;
     constexpr size_t maxRounds = 250;
 
-    std::vector<float> newEasings;
     newEasings.resize(path.checkpoints.size(), 0.f);
 
     path.adjustedStartEaseDuration = path.startEaseDuration;
@@ -584,8 +1197,9 @@ void adjustEaseDurationsP(Path& path)
     // }
     // SDFLUSH();
 
+    const ProfileScope scope("adjustEaseDurationsP");
+    size_t round = 0;
     if (!path.checkpoints.empty()) {
-        size_t round = 0;
 
         while (round < maxRounds) {
             ++round;
@@ -637,6 +1251,7 @@ void adjustEaseDurationsP(Path& path)
         //SDBUFFER("Solved in %@ rounds", round);
         //SDFLUSH();
     }
+    profileSample(Metric::AdjustRounds, static_cast<float>(round));
 
     // Now truncate start/end easings.
 
@@ -659,47 +1274,149 @@ void adjustEaseDurationsP(Path& path)
     }
 }
 
-void solve(AppState& app, std::vector<Result>& results, const bool adjustEase)
+void solve(const SolveInput& input, const EaseInOut variant, SolveHistory& history)
 {
-    results.clear();
-    results.emplace_back();
-    results.back().easeInOut = (&results == &app._resultsLinear) ? kEaseInOutLinear : kEaseInOutSine;
-    results.back().velocities.resize(app._path.checkpoints.size() + 1);
+    const ProfileScope scope("solve");
+    const Path& path = input.path;
+    history.easeInOut = variant;
+    history.stride = path.checkpoints.size() + 1;
+    history.velocities.clear();
+    history.errors.clear();
+    history.retained.clear();
+    history.selectedStep = -1;
+    history.system.solution.clear();
+
+    // only the velocities are refined in place, the tessellation is built when a step gets selected
+    Result result { .easeInOut = history.easeInOut };
 
     //std::println("Lowest,Highest,Sum,SumAbs,SumSq,SumPoz,SumNeg,Velocities");
-    if (adjustEase) {
-        adjustEaseDurationsP(app._path);
-    }
-    seedInitialVelocities(app._path, results.back());
-    tessellateVelocity(app, results.back());
-    tessellateProgress(app, results.back());
-    tessellateAcceleration(app, results.back());
-    [[maybe_unused]] const auto start = std::chrono::high_resolution_clock::now();
-    float prevError = 0;
-    if (results.back().velocities.size() > 1) {
-        while (true) {
-            Result& result = results.emplace_back(results.back());
-            const float error = refineVelocities(app._path, result);
-            tessellateVelocity(app, result);
-            tessellateProgress(app, result);
-            tessellateAcceleration(app, result);
-            const float errDelta = std::abs(error - prevError);
-            //std::println("Error delta: {}", errDelta);
-            if (errDelta <= 1e-5f) {
-                break;
-            }
-            prevError = error;
+    seedInitialVelocities(path, result);
+    [[maybe_unused]] const float finalError = withEaseInOut(history.easeInOut, [&](const auto& easeInOut) {
+        result.totalErrorAbs = static_cast<double>(measureProgressError(path, easeInOut, result.velocities).sumErrorAbs);
+        recordStep(input, history, result);
+        float prevError = 0;
+        if (input.solverMode == SolverMode::Direct) {
+            prevError = solveVelocitiesDirect(path, easeInOut, history.system, result);
+            recordStep(input, history, result);
+        } else {
+            prevError = solveVelocitiesIterative(path, easeInOut, result, [&] { recordStep(input, history, result); });
+        }
+        return prevError;
+    });
+    profileSample(Metric::RefineIterations, static_cast<float>(history.stepCount() - 1));
+}
+
+void solveIncremental(const SolveInput& input, SolveHistory& history, const int firstEase, const int lastEase)
+{
+    const Path& path = input.path;
+    const size_t count = path.checkpoints.size() + 1;
+    VelocitySystem& system = history.system;
+    if (input.solverMode != SolverMode::Direct || input.retainFullResults || system.solution.size() != count || history.stepCount() != 2) {
+        solve(input, history.easeInOut, history);
+        return;
+    }
+    R_ASSERT(firstEase <= lastEase);
+    R_ASSERT(lastEase >= -1);
+
+    withEaseInOut(history.easeInOut, [&](const auto& easeInOut) {
+        // closed before the retessellation, which is timed on its own
+        std::optional<ProfileScope> solveScope;
+        solveScope.emplace("solveIncremental");
+        // an ease is read by the rows of the checkpoints on both of its sides
+        const size_t firstRow = static_cast<size_t>(std::max(firstEase, 0));
+        const size_t lastRow = std::min(static_cast<size_t>(lastEase + 1), count - 1);
+        for (size_t k = firstRow; k <= lastRow; ++k) {
+            buildVelocityRow(path, easeInOut, k, system);
         }
+        const auto [first, last] = resolveVelocityRows(system, firstRow, lastRow);
+
+        // the seed velocities don't depend on the eases, only their error does
+        const std::span<float> seed = std::span(history.velocities).first(count);
+        const std::span<float> solved = std::span(history.velocities).subspan(count, count);
+        for (size_t k = first; k < last; ++k) {
+            solved[k] = static_cast<float>(system.solution[k]);
+        }
+        history.errors[0] = static_cast<double>(measureProgressError(path, easeInOut, seed).sumErrorAbs);
+        history.errors[1] = static_cast<double>(measureProgressError(path, easeInOut, solved).sumErrorAbs);
+        solveScope.reset();
+
+        if (history.selectedStep == 1) {
+            Result& result = history.selected;
+            std::copy(solved.begin() + static_cast<std::ptrdiff_t>(first), solved.begin() + static_cast<std::ptrdiff_t>(last), result.velocities.begin() + static_cast<std::ptrdiff_t>(first));
+            result.totalErrorAbs = history.errors[1];
+            const ProfileScope tessellateScope("retessellate", Metric::TessellateTime);
+            retessellate(path, easeInOut, input.tessellationTolerance, result);
+            profileSample(Metric::PointsEmitted, static_cast<float>(tessellatedPoints(result)));
+        } else {
+            history.selectedStep = -1;
+        }
+    });
+}
+
+const Result& selectStep(const SolveInput& input, SolveHistory& history, const int step)
+{
+    const size_t index = static_cast<size_t>(std::clamp(step, 0, history.stepCount() - 1));
+    if (!history.retained.empty()) {
+        return history.retained[index];
+    }
+    Result& result = history.selected;
+    if (history.selectedStep != static_cast<int>(index)) {
+        const auto first = history.velocities.begin() + static_cast<std::ptrdiff_t>(index * history.stride);
+        result.easeInOut = history.easeInOut;
+        result.velocities.assign(first, first + static_cast<std::ptrdiff_t>(history.stride));
+        result.totalErrorAbs = history.errors[index];
+        tessellate(input.path, input.tessellationTolerance, result);
+        history.selectedStep = static_cast<int>(index);
+    }
+    return result;
+}
+
+void solveBatch(const std::span<Path> paths, const BatchSettings& settings, WorkerPool& pool, BatchSolution& solution)
+{
+    // lay the output out up front, so the workers only write into their own slices of it
+    solution.offsets.resize(paths.size() + 1);
+    size_t offset = 0;
+    for (size_t index = 0; index < paths.size(); ++index) {
+        solution.offsets[index] = offset;
+        offset += paths[index].checkpoints.size() + 1;
+    }
+    solution.offsets[paths.size()] = offset;
+    solution.velocities.resize(offset);
+    solution.errors.resize(paths.size());
+    solution.steps.resize(paths.size());
+    solution.tessellated.resize(settings.tessellate ? paths.size() : 0);
+    solution.progress.resize(paths.size() * settings.progressSamples);
+
+    // largest first: the workers run their own queues oldest first and steal the newest, so the
+    // long paths start early and the short ones fill the gaps at the end
+    std::vector<size_t>& order = solution.order;
+    order.resize(paths.size());
+    std::iota(order.begin(), order.end(), size_t { 0 });
+    std::ranges::stable_sort(order, std::ranges::greater {}, [&](const size_t index) { return paths[index].checkpoints.size(); });
+
+    // kept in the solution, so the buffers carry over to the next batch
+    solution.scratch.resize(pool.threadCount() + 1);
+    BatchContext context {
+        .paths      = paths,
+        .settings   = settings,
+        .solution   = solution,
+        .pool       = pool,
+        .scratch    = solution.scratch,
+        .done       = std::latch(static_cast<std::ptrdiff_t>(paths.size())),
+    };
+    for (const size_t index : order) {
+        // small enough a capture for std::function to store it without allocating
+        pool.post([batch = &context, index] { solveBatchPath(*batch, index); });
     }
-    app._selectedResult = static_cast<int>(results.size()) - 1;
-    [[maybe_unused]] const auto end = std::chrono::high_resolution_clock::now();
-    //std::println("Calculation took: {} in {} iterations, with final error of: {}", end-start, results.size(), prevError);
+    context.done.wait();
 }
 
-void alignEaseDurations(Path& path, const int modifiedIndex)
+std::pair<int, int> alignEaseDurations(Path& path, const int modifiedIndex)
 {
     //constexpr float kEasingGuard = .9999f;
     constexpr float kEasingGuard = 1.f;
+    int firstChanged = modifiedIndex;
+    int lastChanged = modifiedIndex;
     if (modifiedIndex < static_cast<int>(path.checkpoints.size())) {
         float prevEaseDuration = modifiedIndex == -1 ? path.adjustedStartEaseDuration : path.checkpoints[static_cast<size_t>(modifiedIndex)].adjustedEaseDuration / 2.f;
         float prevTime = modifiedIndex == -1 ? path.startTime : path.checkpoints[static_cast<size_t>(modifiedIndex)].time;
@@ -712,6 +1429,7 @@ void alignEaseDurations(Path& path, const int modifiedIndex)
             if (remainingDuration < 0.f) {
                 checkpoint.adjustedEaseDuration = 0.f;
                 forcedExit = true;
+                lastChanged = index;
                 break;
             }
             if (remainingDuration * 2.f > checkpoint.easeDuration) {
@@ -719,6 +1437,7 @@ void alignEaseDurations(Path& path, const int modifiedIndex)
                     checkpoint.adjustedEaseDuration = checkpoint.easeDuration * kEasingGuard;
                 }
                 forcedExit = true;
+                lastChanged = index;
                 break;
             }
             checkpoint.adjustedEaseDuration = remainingDuration * 2.f * kEasingGuard;
@@ -726,6 +1445,7 @@ void alignEaseDurations(Path& path, const int modifiedIndex)
             prevTime = currentTime;
         }
         if (!forcedExit) {
+            lastChanged = static_cast<int>(path.checkpoints.size());
             const float currentTime = path.endTime;
             const float currentDuration = currentTime - prevTime;
             const float remainingDuration = currentDuration - prevEaseDuration;
@@ -750,6 +1470,7 @@ void alignEaseDurations(Path& path, const int modifiedIndex)
             if (remainingDuration < 0.f) {
                 checkpoint.adjustedEaseDuration = 0.f;
                 forcedExit = true;
+                firstChanged = index;
                 break;
             }
             if (remainingDuration * 2.f > checkpoint.easeDuration) {
@@ -757,6 +1478,7 @@ void alignEaseDurations(Path& path, const int modifiedIndex)
                     checkpoint.adjustedEaseDuration = checkpoint.easeDuration * kEasingGuard;
                 }
                 forcedExit = true;
+                firstChanged = index;
                 break;
             }
             checkpoint.adjustedEaseDuration = remainingDuration * 2.f * kEasingGuard;
@@ -764,6 +1486,7 @@ void alignEaseDurations(Path& path, const int modifiedIndex)
             prevTime = currentTime;
         }
         if (!forcedExit) {
+            firstChanged = -1;
             const float currentTime = path.startTime;
             const float currentDuration = prevTime - currentTime;
             const float remainingDuration = currentDuration - prevEaseDuration;
@@ -776,4 +1499,5 @@ void alignEaseDurations(Path& path, const int modifiedIndex)
             }
         }
     }
+    return { firstChanged, lastChanged };
 }
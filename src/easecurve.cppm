@@ -1,3 +1,4 @@
+module;
 
 #include "alx/rassert.h"
 
@@ -48,15 +49,40 @@ export struct EaseCurve
     //! Get the acceleration of the curve for the given x
     [[nodiscard]] float accel(float x) const;
 
+    // Samples the curve for increasing x in one sweep: each lookup moves forward from the segment of
+    // the previous one, so a sweep over the whole curve costs O(1) per sample on average. A smaller x
+    // than the previous one starts over with a binary search. Valid while the curve is not solved again.
+    struct Sampler
+    {
+        explicit Sampler(const EaseCurve& curve) : _curve {&curve} {}
+
+        [[nodiscard]] float evaluate(float x);
+        [[nodiscard]] float speed(float x);
+        [[nodiscard]] float accel(float x);
+
+        // internal (private)
+        [[nodiscard]] size_t advance(float scaledX);
+
+        const EaseCurve*    _curve;
+        size_t              _segment    = 0;
+    };
+    [[nodiscard]] Sampler sampler() const { return Sampler {*this}; }
+
+    //! Evaluate, speed and accel for increasing xs in one sweep, kLanes at a time without branches. All
+    //! spans must have the same size.
+    void evaluateBatch(std::span<const float> xs, std::span<float> values, std::span<float> speeds, std::span<float> accels) const;
+
     // internal (private)
     void setRadius();
     void solve();
+    //! Index of the first segment ending at or after the (unstretched) x, _scaledSegments.size() past the end.
+    [[nodiscard]] size_t findSegment(float scaledX) const;
 
     // internal (private)
     using Point = va::Vec2f;
 
     // internal helper structs
-    enum class Side
+    enum class Side : std::uint8_t
     {
         Auto,
         ForceTrue,
@@ -104,6 +130,105 @@ export struct EaseCurve
         };
         SegmentType type;
     };
+    // The segments as separate arrays, for evaluateBatch(). A line is a circle without radius or sign
+    // and a circle a line without slope or offset, so with
+    //     root = sqrt(max(sqRadius - (x - centerX)^2, kMinRootSq))
+    // the same formulas cover both:
+    //     y(x) = centerY + deltaY + slope * x + sign * root
+    //     speed(x) = slope - sign * (x - centerX) / root
+    //     accel(x) = -sign * sqRadius / root^2 / root
+    // An all zero segment after the last one stands for the x outside the curve. The segment of an x
+    // comes from _breakpoints, so the x ranges aren't kept here.
+    struct SegmentArrays
+    {
+        void clear();
+        void push_back(const Segment& segment);
+
+        std::vector<float> centerX;
+        std::vector<float> centerY;
+        std::vector<float> sqRadius;
+        std::vector<float> sign;
+        std::vector<float> slope;
+        std::vector<float> deltaY;
+    };
+
+    // Everything kept for an intermediate point, params and solved state together, so that solving
+    // walks a single array and starts over by resetting the records in place.
+    struct PointRecord
+    {
+        // flags
+        static constexpr std::uint8_t kAbove = 1 << 0;              // the circle goes above the curve
+        static constexpr std::uint8_t kOriginallyAbove = 1 << 1;    // it did before any flip
+        static constexpr std::uint8_t kXValid = 1 << 2;
+        static constexpr std::uint8_t kYValid = 1 << 3;
+
+        [[nodiscard]] bool has(const std::uint8_t flag) const { return (flags & flag) != 0; }
+        void set(const std::uint8_t flag, const bool value) { flags = static_cast<std::uint8_t>(value ? (flags | flag) : (flags & ~flag)); }
+        //! Whether solving left the circle at its full radius, on its automatic side.
+        [[nodiscard]] bool untouched() const { return reducedRadius == radius && autoSide == Side::Auto; }
+        //! Whether the circle was solved to the same place as the one of other.
+        [[nodiscard]] bool sameCircle(const PointRecord& other) const
+        {
+            return scaledCenter.x() == other.scaledCenter.x() && scaledCenter.y() == other.scaledCenter.y() && reducedRadius == other.reducedRadius
+                && autoSide == other.autoSide && has(kAbove) == other.has(kAbove);
+        }
+        //! Take the solved state of other, keeping the params and the validity flags.
+        void takeSolved(const PointRecord& other)
+        {
+            scaledCenter = other.scaledCenter;
+            reducedRadius = other.reducedRadius;
+            autoSide = other.autoSide;
+            set(kAbove, other.has(kAbove));
+            set(kOriginallyAbove, other.has(kOriginallyAbove));
+        }
+
+        // params
+        Point point = {};
+        float radius = kDefaultRadius;
+        // calculated by invoking solve()
+        Point scaledCenter = {};
+        float reducedRadius = kDefaultRadius;
+        Side autoSide = Side::Auto;
+        std::uint8_t flags = kXValid | kYValid;
+    };
+
+    // The solve before solveAround() from the first pair past the changed points on, for solveFrom()
+    // to take over once it catches up with it.
+    struct PreviousTail
+    {
+        size_t                      firstPair           = 0;    // in the current indices, 0 for none
+        size_t                      restoredFrom        = 0;    // the pair the tail was taken from, 0 for none
+        std::vector<PointRecord>    records             = {};   // of the points from firstPair - 1 on
+        std::vector<Segment>        segments            = {};   // of the pairs from firstPair on, after the cruise before them
+        Point                       lastCenter          = {};
+        float                       lastReducedRadius   = 0;
+    };
+
+    // internal (private)
+    //! Re-solve after the points [first, last] or their neighbours changed, -1 standing for the first
+    //! point and _pointRecords.size() for the last one, and shift points were inserted (removed if
+    //! negative) before the ones after last. Keeps the segments and circles before them as solved, and
+    //! those after them once the solve reaches them unchanged.
+    void solveAround(int first, int last, int shift);
+    void solveGlobally();
+    //! Solve the pairs from pair on, keeping the segments before it. Pair i joins the circles of points
+    //! i - 1 and i, the first and last points included.
+    void solveFrom(size_t pair);
+    //! Take the rest of the previous tail if pair is where it starts and joins the circles it did,
+    //! returning true, or start its circles over if they were taken from it before.
+    [[nodiscard]] bool catchUp(size_t pair);
+    void placeEnds();
+    void placeCircle(size_t index);
+    //! Back to the full radius on the automatic side.
+    void restartCircle(size_t index);
+    //! Reduce the radii of a pair or add its segments, returning false if it reduced them.
+    [[nodiscard]] bool solvePair(size_t pair);
+    //! The first circle from first on to flip, _pointRecords.size() if none.
+    [[nodiscard]] size_t findFlip(size_t first) const;
+    //! Force the circle to the other side from now on.
+    void flipCircle(size_t index);
+    void buildIndex();
+    [[nodiscard]] Point unstretch(const Point point) const { return Point {{point.x() / _xStretch, point.y()}}; }
 
     // internal (private)
     // params
@@ -114,19 +239,14 @@ export struct EaseCurve
     float _firstRadius = kDefaultRadius;
     float _lastRadius = kDefaultRadius;
     Point _lastPoint = kDefaultLastPoint;
-    std::vector<Point> _points;
-    std::vector<float> _radii;
+    // of the intermediate points, with the state solve() and validate() calculate for them
+    std::vector<PointRecord> _pointRecords;
 
     // calculated by invoking solve()
     Point _scaledFirstCenter;
     Point _scaledLastCenter;
     float _firstReducedRadius;
     float _lastReducedRadius;
-    std::vector<Point> _scaledCenters;
-    std::vector<bool> _sides;
-    std::vector<bool> _originalSides;
-    std::vector<Side> _autoSides;
-    std::vector<float> _reducedRadii;
 
     // debugging information
     long long _solveTimeUs = 0;
@@ -134,15 +254,25 @@ export struct EaseCurve
 
     // needed for evaluate(), speed() and accel()
     std::vector<Segment> _scaledSegments;
+    // the largest finalX of the segments up to each one, ascending even when a segment runs backwards,
+    // so the first breakpoint not below x is the first segment ending at or after x
+    std::vector<float> _breakpoints;
+    // needed for evaluateBatch()
+    SegmentArrays _segmentArrays;
+    // kept from solve to solve for the capacity
+    PreviousTail _previousTail;
 
     // calculated by invoking validate()
-    std::vector<bool> _pointsXValid;
-    std::vector<bool> _pointsYValid;
     bool _valid = true;
 
     // more params
     bool _autoFlip = true;
     bool _reduceRadii = true;
+    // after a reduction or a flip carry on from the changed circles instead of starting over, and
+    // re-solve only around the points that are added, inserted or removed
+    bool _localRestarts = true;
+    // reduce the radii by solving for where the circles clear each other rather than bisecting for it
+    bool _analyticReduction = true;
 
     // internal (private)
     // default values
@@ -151,6 +281,10 @@ export struct EaseCurve
     static constexpr float kDefaultRadius = 1.f;
     static constexpr float kMinDistance = 0.01f;
     static constexpr float kPrecision = 0.000001f;
+    // samples per block of evaluateBatch(), one 256 bit register of floats
+    static constexpr size_t kLanes = 8;
+    // keeps the root of a line, and of a circle at its vertical tangents, finite and above zero
+    static constexpr float kMinRootSq = std::numeric_limits<float>::min();
 };
 
 namespace {
@@ -159,27 +293,30 @@ void validate(EaseCurve& curve)
 {
     curve._valid = true;
 
-    auto count = curve._points.size();
+    using PointRecord = EaseCurve::PointRecord;
     EaseCurve::Point prevPoint = EaseCurve::kFirstPoint;
     // check that points are in ascending order
-    for (decltype (count) i = 0; i < count; ++i) {
-        const EaseCurve::Point point = curve._points[i];
+    for (PointRecord& record: curve._pointRecords) {
+        const EaseCurve::Point point = record.point;
         // check each x is in [0, lastX] and (prevPoint.x, lastX]
-        if (!(curve._pointsXValid[i] = !(point.x() < 0.f || point.x() > curve._lastPoint.x()) && point.x() > prevPoint.x())) {
-            curve._valid = false;
-        }
+        const bool xValid = !(point.x() < 0.f || point.x() > curve._lastPoint.x()) && point.x() > prevPoint.x();
         // check each y is in [0, lastY] and [prevPoint.y, lastY]
-        if (!(curve._pointsYValid[i] = !(point.y() < 0.f || point.y() > curve._lastPoint.y()) && point.y() > prevPoint.y())) {
+        const bool yValid = !(point.y() < 0.f || point.y() > curve._lastPoint.y()) && point.y() > prevPoint.y();
+        record.set(PointRecord::kXValid, xValid);
+        record.set(PointRecord::kYValid, yValid);
+        if (!xValid || !yValid) {
             curve._valid = false;
         }
         prevPoint = point;
     }
-    if (count) {
+    if (!curve._pointRecords.empty()) {
         // check last x and y are not less than end point
-        if (!(curve._pointsXValid.back() = curve._pointsXValid.back() && prevPoint.x() < curve._lastPoint.x())) {
-            curve._valid = false;
-        }
-        if (!(curve._pointsYValid.back() = curve._pointsYValid.back() && prevPoint.y() < curve._lastPoint.y())) {
+        PointRecord& record = curve._pointRecords.back();
+        const bool xValid = record.has(PointRecord::kXValid) && prevPoint.x() < curve._lastPoint.x();
+        const bool yValid = record.has(PointRecord::kYValid) && prevPoint.y() < curve._lastPoint.y();
+        record.set(PointRecord::kXValid, xValid);
+        record.set(PointRecord::kYValid, yValid);
+        if (!xValid || !yValid) {
             curve._valid = false;
         }
     }
@@ -256,6 +393,105 @@ inline SolveResult solve(const float initialX, const EaseCurve::Point leftCenter
     return {speedUp, cruise};
 }
 
+float dot(const EaseCurve::Point a, const EaseCurve::Point b)
+{
+    return a.x() * b.x() + a.y() * b.y();
+}
+
+// The distance left between a point and a circle shrunk toward its own point by ratio (or between two
+// circles on opposite sides, shrunk together, with their radii summed), beyond the min distance:
+//     |offset + delta * ratio| - radius * ratio - minDistance
+// It is convex in the ratio, so it turns negative at most once in [0, 1].
+struct ReductionDistance
+{
+    EaseCurve::Point offset;
+    EaseCurve::Point delta;
+    float radius;
+    float minDistance;
+
+    [[nodiscard]] float operator()(const float ratio) const { return (offset + delta * ratio).len() - radius * ratio - minDistance; }
+};
+
+// Bisects the ratio down to the curve's precision, keeping the side where the distance is positive.
+float bisectRatio(EaseCurve& curve, const ReductionDistance& distance)
+{
+    float minRatio = 0.f;
+    float maxRatio = 1.f;
+    while (true) {
+        const float minDelta = distance(minRatio);
+        const float maxDelta = distance(maxRatio);
+        const float midRatio = (minRatio + maxRatio) / 2;
+        if ((std::abs(minDelta + maxDelta) < curve._precision) || (midRatio <= minRatio) || (midRatio >= maxRatio)) {
+            return minRatio;
+        }
+        const float midDelta = distance(midRatio);
+        if (midDelta > 0.f) {
+            minRatio = midRatio;
+        } else {
+            maxRatio = midRatio;
+        }
+        ++curve._iterations;
+    }
+}
+
+// Solves for the ratio directly: squared, the distance is zero at a root of
+//     (delta.delta - radius^2) ratio^2 + 2 (offset.delta - radius minDistance) ratio + offset.offset - minDistance^2
+// which is nearly linear for a circle against a point, its delta being as long as its radius. The
+// root is then moved back by Newton steps to where the distance is about the precision, where the
+// bisection stops. Empty when the float math can't confirm a positive distance there.
+std::optional<float> solveRatio(EaseCurve& curve, const ReductionDistance& distance)
+{
+    ++curve._iterations;
+    const double radius = static_cast<double>(distance.radius);
+    const double minDistance = static_cast<double>(distance.minDistance);
+    const double a = static_cast<double>(dot(distance.delta, distance.delta)) - radius * radius;
+    const double b = 2. * (static_cast<double>(dot(distance.offset, distance.delta)) - radius * minDistance);
+    const double c = static_cast<double>(dot(distance.offset, distance.offset)) - minDistance * minDistance;
+    const double discriminant = b * b - 4. * a * c;
+    if (discriminant < 0.) {
+        return std::nullopt;
+    }
+    // the stable pair of roots, without cancelling b
+    const double q = -0.5 * (b + std::copysign(std::sqrt(discriminant), b));
+    double root = std::numeric_limits<double>::infinity();
+    for (const double candidate: { (a != 0.) ? q / a : root, (q != 0.) ? c / q : root }) {
+        if (candidate >= 0. && candidate <= 1.) {
+            root = std::min(root, candidate);
+        }
+    }
+    if (root > 1.) {
+        return std::nullopt;
+    }
+
+    float ratio = static_cast<float>(root);
+    float target = curve._precision;
+    for (int step = 0; step < 3; ++step) {
+        const EaseCurve::Point reduced = distance.offset + distance.delta * ratio;
+        const float slope = dot(reduced, distance.delta) / reduced.len() - distance.radius;
+        if (!(slope < 0.f)) {
+            return std::nullopt;
+        }
+        ratio = std::clamp(ratio + (target - distance(ratio)) / slope, 0.f, 1.f);
+        if (distance(ratio) > 0.f) {
+            return ratio;
+        }
+        // still on the wrong side after rounding, aim further out
+        target *= 4.f;
+        ++curve._iterations;
+    }
+    return std::nullopt;
+}
+
+float reductionRatio(EaseCurve& curve, const ReductionDistance& distance)
+{
+    if (curve._analyticReduction) {
+        if (const std::optional<float> ratio = solveRatio(curve, distance)) {
+            return *ratio;
+        }
+    }
+    return bisectRatio(curve, distance);
+}
+
 bool reduceRadii(EaseCurve& curve, const EaseCurve::Point& leftPoint, EaseCurve::Point& leftCenter, float& leftRadius, bool leftSide, const EaseCurve::Point& rightPoint, EaseCurve::Point& rightCenter, float& rightRadius, bool rightSide)
 {
     // check and reduce the radii if needed
@@ -269,50 +505,18 @@ bool reduceRadii(EaseCurve& curve, const EaseCurve::Point& leftPoint, EaseCurve:
                 // right point is "inside" the left circle
                 const EaseCurve::Point pointDelta = leftPoint - rightPoint;
                 const EaseCurve::Point leftDelta = leftCenter - leftPoint;
-                float minRatio = 0.f;
-                float maxRatio = 1.f;
-                while (true) {
-                    const float minDelta = (pointDelta + leftDelta * minRatio).len() - leftRadius * minRatio - minDistance;
-                    const float maxDelta = (pointDelta + leftDelta * maxRatio).len() - leftRadius * maxRatio - minDistance;
-                    const float midRatio = (minRatio + maxRatio) / 2;
-                    if ((std::abs(minDelta + maxDelta) < curve._precision) || (midRatio <= minRatio) || (midRatio >= maxRatio)) {
-                        leftRadius *= minRatio;
-                        leftCenter = leftPoint + leftDelta * minRatio;
-                        break;
-                    }
-                    const float midDelta = (pointDelta + leftDelta * midRatio).len() - leftRadius * midRatio - minDistance;
-                    if (midDelta > 0.f) {
-                        minRatio = midRatio;
-                    } else {
-                        maxRatio = midRatio;
-                    }
-                    ++curve._iterations;
-                }
+                const float ratio = reductionRatio(curve, {pointDelta, leftDelta, leftRadius, minDistance});
+                leftRadius *= ratio;
+                leftCenter = leftPoint + leftDelta * ratio;
             }
             const bool reduceRightSide = (rightRadius > 0.f) && (rightCenter - leftPoint).len() - rightRadius - minDistance < 0;
             if (reduceRightSide) {
                 // first point is "inside" the second circle
                 const EaseCurve::Point pointDelta = rightPoint - leftPoint;
                 const EaseCurve::Point rightDelta = rightCenter - rightPoint;
-                float minRatio = 0.f;
-                float maxRatio = 1.f;
-                while (true) {
-                    const float minDelta = (pointDelta + rightDelta * minRatio).len() - rightRadius * minRatio - minDistance;
-                    const float maxDelta = (pointDelta + rightDelta * maxRatio).len() - rightRadius * maxRatio - minDistance;
-                    const float midRatio = (minRatio + maxRatio) / 2;
-                    if ((std::abs(minDelta + maxDelta) < curve._precision) || (midRatio <= minRatio) || (midRatio >= maxRatio)) {
-                        rightRadius *= minRatio;
-                        rightCenter = rightPoint + rightDelta * minRatio;
-                        break;
-                    }
-                    const float midDelta = (pointDelta + rightDelta * midRatio).len() - rightRadius * midRatio - minDistance;
-                    if (midDelta > 0.f) {
-                        minRatio = midRatio;
-                    } else {
-                        maxRatio = midRatio;
-                    }
-                    ++curve._iterations;
-                }
+                const float ratio = reductionRatio(curve, {pointDelta, rightDelta, rightRadius, minDistance});
+                rightRadius *= ratio;
+                rightCenter = rightPoint + rightDelta * ratio;
             }
             if (reduceLeftSide || reduceRightSide) {
                 return true;
@@ -328,27 +532,11 @@ bool reduceRadii(EaseCurve& curve, const EaseCurve::Point& leftPoint, EaseCurve:
             if (centerDelta.len() - totalRadius - minDistance < 0) {
                 // circles are "overlapping"
                 const EaseCurve::Point centerDiff = centerDelta - pointDiff;
-                float minRatio = 0.f;
-                float maxRatio = 1.f;
-                while (true) {
-                    const float minDelta = (pointDiff + centerDiff * minRatio).len() - totalRadius * minRatio - minDistance;
-                    const float maxDelta = (pointDiff + centerDiff * maxRatio).len() - totalRadius * maxRatio - minDistance;
-                    const float midRatio = (minRatio + maxRatio) / 2;
-                    if ((std::abs(minDelta + maxDelta) < curve._precision) || (midRatio <= minRatio) || (midRatio >= maxRatio)) {
-                        leftRadius *= minRatio;
-                        leftCenter = leftPoint + leftDelta * minRatio;
-                        rightRadius *= minRatio;
-                        rightCenter = rightPoint + rightDelta * minRatio;
-                        break;
-                    }
-                    const float midDelta = (pointDiff + centerDiff * midRatio).len() - totalRadius * midRatio - minDistance;
-                    if (midDelta > 0.f) {
-                        minRatio = midRatio;
-                    } else {
-                        maxRatio = midRatio;
-                    }
-                    ++curve._iterations;
-                }
+                const float ratio = reductionRatio(curve, {pointDiff, centerDiff, totalRadius, minDistance});
+                leftRadius *= ratio;
+                leftCenter = leftPoint + leftDelta * ratio;
+                rightRadius *= ratio;
+                rightCenter = rightPoint + rightDelta * ratio;
                 return true;
             }
         }
@@ -395,15 +583,17 @@ bool reduceRadii(EaseCurve& curve, const EaseCurve::Point& leftPoint, EaseCurve:
 #else
             if ((res.cruise.finalX - res.cruise.initialX - minDistance < 0) || (res.cruise.finalY() - res.cruise.initialY() - minDistance < 0)) {
                 // the constant speed segment goes "backwards"
+                // the cruise segment at a ratio, as its x and y lengths beyond the min distance
+                const auto cruiseDeltas = [&](const float ratio) {
+                    const SolveResult& ratioRes = ::solve(0, leftPoint + leftDelta * ratio, leftRadius * ratio, leftSide, rightPoint + rightDelta * ratio, rightRadius * ratio, rightSide);
+                    return std::pair {ratioRes.cruise.finalX - ratioRes.cruise.initialX - minDistance, ratioRes.cruise.finalY() - ratioRes.cruise.initialY() - minDistance};
+                };
                 float minRatio = 0.f;
                 float maxRatio = 1.f;
+                // each step moves one bound to the middle, so only the middle is solved
+                auto [minXDelta, minYDelta] = cruiseDeltas(minRatio);
+                auto [maxXDelta, maxYDelta] = cruiseDeltas(maxRatio);
                 while (true) {
-                    const SolveResult& minRes = ::solve(0, leftPoint + leftDelta * minRatio, leftRadius * minRatio, leftSide, rightPoint + rightDelta * minRatio, rightRadius * minRatio, rightSide);
-                    const SolveResult& maxRes = ::solve(0, leftPoint + leftDelta * maxRatio, leftRadius * maxRatio, leftSide, rightPoint + rightDelta * maxRatio, rightRadius * maxRatio, rightSide);
-                    const float minXDelta = minRes.cruise.finalX - minRes.cruise.initialX - minDistance;
-                    const float minYDelta = minRes.cruise.finalY() - minRes.cruise.initialY() - minDistance;
-                    const float maxXDelta = maxRes.cruise.finalX - maxRes.cruise.initialX - minDistance;
-                    const float maxYDelta = maxRes.cruise.finalY() - maxRes.cruise.initialY() - minDistance;
                     const float midRatio = (minRatio + maxRatio) / 2;
                     const bool degenerateCase = (minXDelta < 0.f) || (minYDelta < 0.f) || (midRatio <= minRatio) || (midRatio >= maxRatio);
                     const bool reachedPrecision = (std::abs(minXDelta + maxXDelta) < curve._precision) && (std::abs(minYDelta + maxYDelta) < curve._precision);
@@ -414,13 +604,15 @@ bool reduceRadii(EaseCurve& curve, const EaseCurve::Point& leftPoint, EaseCurve:
                         rightCenter = rightPoint + rightDelta * minRatio;
                         break;
                     }
-                    const SolveResult& midRes = ::solve(0, leftPoint + leftDelta * midRatio, leftRadius * midRatio, leftSide, rightPoint + rightDelta * midRatio, rightRadius * midRatio, rightSide);
-                    const float midXDelta = midRes.cruise.finalX - midRes.cruise.initialX - minDistance;
-                    const float midYDelta = midRes.cruise.finalY() - midRes.cruise.initialY() - minDistance;
+                    const auto [midXDelta, midYDelta] = cruiseDeltas(midRatio);
                     if ((midXDelta > 0.f) && (midYDelta > 0.f)) {
                         minRatio = midRatio;
+                        minXDelta = midXDelta;
+                        minYDelta = midYDelta;
                     } else {
                         maxRatio = midRatio;
+                        maxXDelta = midXDelta;
+                        maxYDelta = midYDelta;
                     }
                     ++curve._iterations;
                 }
@@ -436,37 +628,44 @@ bool reduceRadii(EaseCurve& curve, const EaseCurve::Point& leftPoint, EaseCurve:
 
 void EaseCurve::addPoint(float x, float y, float radius)
 {
-    _points.push_back({{x, y}});
-    _radii.push_back(radius);
-    _pointsXValid.push_back(true);
-    _pointsYValid.push_back(true);
-    solve();
+    insertPointAt(static_cast<int>(_pointRecords.size()), x, y, radius);
 }
 
 void EaseCurve::insertPointAt(int index, float x, float y, float radius)
 {
-    _points.insert(_points.begin() + index, {{{{x, y}}}});
-    _radii.insert(_radii.begin() + index, radius);
-    _pointsXValid.push_back(true);
-    _pointsYValid.push_back(true);
-    solve();
+    // solved before, so only around the new point
+    const bool local = _localRestarts && !_scaledSegments.empty();
+    PointRecord record;
+    record.point = {{x, y}};
+    record.radius = radius;
+    record.reducedRadius = radius;
+    _pointRecords.insert(_pointRecords.begin() + index, record);
+    if (!local) {
+        solve();
+        return;
+    }
+    // the neighbours' circles turn around the new point
+    solveAround(index - 1, index + 1, 1);
 }
 
 void EaseCurve::removePointAt(int index)
 {
-    _points.erase(_points.begin() + index);
-    _radii.erase(_radii.begin() + index);
-    _pointsXValid.pop_back();
-    _pointsYValid.pop_back();
-    solve();
+    const bool local = _localRestarts && !_scaledSegments.empty();
+    _pointRecords.erase(_pointRecords.begin() + index);
+    if (!local) {
+        solve();
+        return;
+    }
+    // the neighbours are now next to each other
+    solveAround(index - 1, index, -1);
 }
 
 void EaseCurve::setRadius()
 {
     _firstRadius = _radius;
     _lastRadius = _radius;
-    for (float& r: _radii) {
-        r = _radius;
+    for (PointRecord& record: _pointRecords) {
+        record.radius = _radius;
     }
     solve();
 }
@@ -513,18 +712,52 @@ float EaseCurve::Segment::accel(float x) const
     return 0.f;
 }
 
+size_t EaseCurve::findSegment(const float scaledX) const
+{
+    const auto it = std::lower_bound(_breakpoints.begin(), _breakpoints.end(), scaledX);
+    return static_cast<size_t>(it - _breakpoints.begin());
+}
+
+void EaseCurve::SegmentArrays::clear()
+{
+    centerX.clear();
+    centerY.clear();
+    sqRadius.clear();
+    sign.clear();
+    slope.clear();
+    deltaY.clear();
+}
+
+void EaseCurve::SegmentArrays::push_back(const Segment& segment)
+{
+    switch (segment.type) {
+    case SegmentType::Line:
+        centerX.push_back(0.f);
+        centerY.push_back(0.f);
+        sqRadius.push_back(0.f);
+        sign.push_back(0.f);
+        slope.push_back(segment.line.slope);
+        deltaY.push_back(segment.line.deltaY);
+        return;
+    case SegmentType::Circle:
+        centerX.push_back(segment.circle.center.x());
+        centerY.push_back(segment.circle.center.y());
+        sqRadius.push_back(segment.circle.sqRadius);
+        sign.push_back(segment.circle.sign);
+        slope.push_back(0.f);
+        deltaY.push_back(0.f);
+        return;
+    }
+}
+
 float EaseCurve::evaluate(float x) const
 {
     x /= _xStretch;
     if (x < 0) {
         return 0.f;
     }
-    for (const EaseCurve::Segment& segment: _scaledSegments) {
-        if (x <= segment.finalX) {
-            return segment.evaluate(x);
-        }
-    }
-    return 0.f;
+    const size_t index = findSegment(x);
+    return index < _scaledSegments.size() ? _scaledSegments[index].evaluate(x) : 0.f;
 }
 
 float EaseCurve::speed(float x) const
@@ -533,12 +766,8 @@ float EaseCurve::speed(float x) const
     if (x < 0) {
         return 0.f;
     }
-    for (const EaseCurve::Segment& segment: _scaledSegments) {
-        if (x <= segment.finalX) {
-            return segment.speed(x);
-        }
-    }
-    return 0.f;
+    const size_t index = findSegment(x);
+    return index < _scaledSegments.size() ? _scaledSegments[index].speed(x) : 0.f;
 }
 
 float EaseCurve::accel(float x) const
@@ -547,12 +776,102 @@ float EaseCurve::accel(float x) const
     if (x < 0) {
         return 0.f;
     }
-    for (const EaseCurve::Segment& segment: _scaledSegments) {
-        if (x <= segment.finalX) {
-            return segment.accel(x);
+    const size_t index = findSegment(x);
+    return index < _scaledSegments.size() ? _scaledSegments[index].accel(x) : 0.f;
+}
+
+void EaseCurve::evaluateBatch(const std::span<const float> xs, const std::span<float> values, const std::span<float> speeds, const std::span<float> accels) const
+{
+    R_ASSERT(values.size() == xs.size());
+    R_ASSERT(speeds.size() == xs.size());
+    R_ASSERT(accels.size() == xs.size());
+    R_ASSERT(!_segmentArrays.centerX.empty()); // solved
+
+    const SegmentArrays& arrays = _segmentArrays;
+    const size_t outside = _scaledSegments.size();
+    Sampler sampler {*this};
+    for (size_t block = 0; block < xs.size(); block += kLanes) {
+        const size_t lanes = std::min(kLanes, xs.size() - block);
+
+        std::array<float, kLanes> x;
+        std::array<float, kLanes> centerX;
+        std::array<float, kLanes> centerY;
+        std::array<float, kLanes> sqRadius;
+        std::array<float, kLanes> sign;
+        std::array<float, kLanes> slope;
+        std::array<float, kLanes> deltaY;
+        for (size_t lane = 0; lane < kLanes; ++lane) {
+            // the lanes past the end of a partial block repeat its last x
+            x[lane] = xs[block + std::min(lane, lanes - 1)] / _xStretch;
+            const size_t index = x[lane] < 0 ? outside : sampler.advance(x[lane]);
+            centerX[lane]   = arrays.centerX[index];
+            centerY[lane]   = arrays.centerY[index];
+            sqRadius[lane]  = arrays.sqRadius[index];
+            sign[lane]      = arrays.sign[index];
+            slope[lane]     = arrays.slope[index];
+            deltaY[lane]    = arrays.deltaY[index];
         }
+
+        std::array<float, kLanes> blockValues;
+        std::array<float, kLanes> blockSpeeds;
+        std::array<float, kLanes> blockAccels;
+        for (size_t lane = 0; lane < kLanes; ++lane) {
+            const float deltaX  = x[lane] - centerX[lane];
+            const float rootSq  = std::max(sqRadius[lane] - deltaX * deltaX, kMinRootSq);
+            const float root    = std::sqrt(rootSq);
+            blockValues[lane]   = centerY[lane] + deltaY[lane] + slope[lane] * x[lane] + sign[lane] * root;
+            blockSpeeds[lane]   = slope[lane] - sign[lane] * deltaX / root;
+            blockAccels[lane]   = -sign[lane] * sqRadius[lane] / rootSq / root;
+        }
+
+        std::copy_n(blockValues.begin(), lanes, values.subspan(block, lanes).begin());
+        std::copy_n(blockSpeeds.begin(), lanes, speeds.subspan(block, lanes).begin());
+        std::copy_n(blockAccels.begin(), lanes, accels.subspan(block, lanes).begin());
     }
-    return 0.f;
+}
+
+size_t EaseCurve::Sampler::advance(const float scaledX)
+{
+    const std::vector<float>& breakpoints = _curve->_breakpoints;
+    if (_segment >= breakpoints.size() || (_segment > 0 && breakpoints[_segment - 1] >= scaledX)) {
+        // past the end or going backwards
+        _segment = _curve->findSegment(scaledX);
+        return _segment;
+    }
+    while (_segment < breakpoints.size() && breakpoints[_segment] < scaledX) {
+        ++_segment;
+    }
+    return _segment;
+}
+
+float EaseCurve::Sampler::evaluate(float x)
+{
+    x /= _curve->_xStretch;
+    if (x < 0) {
+        return 0.f;
+    }
+    const size_t index = advance(x);
+    return index < _curve->_scaledSegments.size() ? _curve->_scaledSegments[index].evaluate(x) : 0.f;
+}
+
+float EaseCurve::Sampler::speed(float x)
+{
+    x /= _curve->_xStretch;
+    if (x < 0) {
+        return 0.f;
+    }
+    const size_t index = advance(x);
+    return index < _curve->_scaledSegments.size() ? _curve->_scaledSegments[index].speed(x) : 0.f;
+}
+
+float EaseCurve::Sampler::accel(float x)
+{
+    x /= _curve->_xStretch;
+    if (x < 0) {
+        return 0.f;
+    }
+    const size_t index = advance(x);
+    return index < _curve->_scaledSegments.size() ? _curve->_scaledSegments[index].accel(x) : 0.f;
 }
 
 void EaseCurve::solve()
@@ -560,133 +879,300 @@ void EaseCurve::solve()
     const auto startTime = std::chrono::steady_clock::now();
     validate(*this);
 
-    const float xStretch = _xStretch;
-    auto unstretch = [xStretch](Point p) { return Point{{p.x() / xStretch, p.y()}}; };
+    const auto size = _pointRecords.size();
 
-    auto size = _points.size();
-
-    _autoSides.clear();
-    _autoSides.resize(size, Side::Auto);
-    _originalSides.clear();
-    _originalSides.resize(size, false);
     _firstReducedRadius = _firstRadius;
     _lastReducedRadius = _lastRadius;
-    _reducedRadii = _radii;
     _iterations = 0;
 
+    // figure out the centers and sides of the circles, from their full radii and automatic sides
+    placeEnds();
+    for (decltype(size) i = 0; i < size; ++i) {
+        restartCircle(i);
+    }
+
+    _scaledSegments.clear();
+    if (_localRestarts) {
+        solveFrom(0);
+    } else {
+        solveGlobally();
+    }
+
+    buildIndex();
+    _solveTimeUs = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+void EaseCurve::solveAround(const int first, const int last, const int shift)
+{
+    const auto startTime = std::chrono::steady_clock::now();
+    const auto size = _pointRecords.size();
+    // a circle reduced or flipped may have been so for the pair on its right, which changed, so those
+    // before the changed ones start over too, back to one the last solve left alone
+    auto start = static_cast<size_t>(std::max(first, 0));
+    while (start > 0 && !_pointRecords[start - 1].untouched()) {
+        --start;
+    }
+    if (start == 0 && _firstReducedRadius < _firstRadius) {
+        solve();
+        return;
+    }
+    validate(*this);
+    _iterations = 0;
+
+    // keep the solve of the points after the changed ones, the segments still in the indices from
+    // before the change
+    PreviousTail& tail = _previousTail;
+    tail.firstPair = 0;
+    tail.restoredFrom = 0;
+    tail.records.clear();
+    tail.segments.clear();
+    const auto firstPair = static_cast<size_t>(last + 2);
+    if (firstPair < size) {
+        const auto previousPair = static_cast<size_t>(static_cast<int>(firstPair) - shift);
+        R_ASSERT(_scaledSegments.size() == static_cast<size_t>(static_cast<int>(size) - shift + 1) * 2 + 1);
+        tail.firstPair = firstPair;
+        tail.records.assign(_pointRecords.begin() + static_cast<std::ptrdiff_t>(firstPair - 1), _pointRecords.end());
+        tail.segments.assign(_scaledSegments.begin() + static_cast<std::ptrdiff_t>(previousPair * 2 - 1), _scaledSegments.end());
+        tail.lastCenter = _scaledLastCenter;
+        tail.lastReducedRadius = _lastReducedRadius;
+    }
+
+    // the changed circles and all after them start over, the ones before keep what they were reduced
+    // or flipped to
+    for (auto i = start; i < size; ++i) {
+        restartCircle(i);
+    }
+    _lastReducedRadius = _lastRadius;
+    placeEnds();
+
+    // pair start is the first one with a changed circle, on its right
+    solveFrom(start);
+    tail.firstPair = 0;
+
+    buildIndex();
+    _solveTimeUs = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+void EaseCurve::solveGlobally()
+{
+    const auto size = _pointRecords.size();
     bool done = false;
     while (!done) {
         done = true;
-        // figure out the centers and sides of the circles
-        {
-            _scaledCenters.clear();
-            _scaledCenters.resize(size, {});
-            _sides.clear();
-            _sides.resize(size, false);
-
-            _scaledFirstCenter = {{kFirstPoint.x(), kFirstPoint.y() + _firstReducedRadius}};
-            _scaledLastCenter = {{_lastPoint.x() / xStretch, _lastPoint.y() - _lastReducedRadius}};
-
-            for (decltype(size) i = 0; i < size; ++i) {
-                const Point prevPoint = unstretch((i == 0) ? kFirstPoint : _points[i - 1]);
-                const Point nextPoint = unstretch((i == size - 1) ? _lastPoint : _points[i + 1]);
-                const Point currPoint = unstretch(_points[i]);
-                // Figure out whether the current circle needs to go "above" or "below" the line segments.
-                // In order to figure that out, we need to see whether the angle (ie. slope) of the consecutive segments
-                // increases or decreases.
-                // When the angle increases, the curve "goes up", so the circle needs to be "above"
-                const trig::RadF leftAngle = (currPoint - prevPoint).angle();
-                const trig::RadF rightAngle = (nextPoint - currPoint).angle();
-                const bool above = (_autoSides[i] == Side::ForceTrue) || ((_autoSides[i] == Side::Auto) && (rightAngle > leftAngle));
-                const trig::RadF signedPi = above ? trig::Straight<trig::RadF> : -trig::Straight<trig::RadF>;
-                const trig::RadF centerAngle = (leftAngle + rightAngle + signedPi) / 2;
-                _sides[i] = above;
-                _scaledCenters[i] = currPoint + Point::fromPolar(centerAngle, _reducedRadii[i]);
-                if (!_iterations) {
-                    _originalSides[i] = above;
-                }
-            }
+        placeEnds();
+        for (decltype(size) i = 0; i < size; ++i) {
+            placeCircle(i);
         }
 
         // split curve into segments
-        {
-            _scaledSegments.clear();
-
-            // start at the first point
-            Point prevPoint = unstretch(kFirstPoint);
-            Point* prevCenter = &_scaledFirstCenter;
-            float* prevRadius = &_firstReducedRadius;
-            bool prevSide = true;
-            float prevInitialX = 0.f;
-            // for each intermediate point
-            for (decltype (size) i = 0; i < size; ++i) {
-                const Point curPoint = unstretch(_points[i]);
-                Point* curCenter = &_scaledCenters[i];
-                float* curRadius = &_reducedRadii[i];
-                const bool curSide = _sides[i];
-
-                if (::reduceRadii(*this, prevPoint, *prevCenter, *prevRadius, prevSide, curPoint, *curCenter, *curRadius, curSide)) {
-                    // we reduced the radii of the circles, start over
-                    done = false;
-                    break;
-                }
-
-                // solve for the current point and previous point pair
-                const SolveResult& res = ::solve(prevInitialX, *prevCenter, *prevRadius, prevSide, *curCenter, *curRadius, curSide);
-                _scaledSegments.push_back(res.speedUp);
-                _scaledSegments.push_back(res.cruise);
-                prevInitialX = res.cruise.finalX;
-
-                // the current point becomes the previous point for the next one
-                prevPoint = curPoint;
-                prevCenter = curCenter;
-                prevRadius = curRadius;
-                prevSide = curSide;
-            }
-            // for the last point
-            if (done) {
-                const Point curPoint = unstretch(_lastPoint);
-                Point* curCenter = &_scaledLastCenter;
-                float* curRadius = &_lastReducedRadius;
-                const bool curSide = false;
-
-                if (::reduceRadii(*this, prevPoint, *prevCenter, *prevRadius, prevSide, curPoint, *curCenter, *curRadius, curSide)) {
-                    // we reduced the radii of the circles, start over
-                    done = false;
-                } else {
-                    // solve for the last point and the previous point pair
-                    const SolveResult& res = ::solve(prevInitialX, *prevCenter, *prevRadius, prevSide, *curCenter, *curRadius, curSide);
-                    _scaledSegments.push_back(res.speedUp);
-                    _scaledSegments.push_back(res.cruise);
-                    prevInitialX = res.cruise.finalX;
-
-                    // also add the final segment, corresponding to the circle on the last point
-                    Segment speedDown = Circle {_scaledLastCenter, _lastReducedRadius * _lastReducedRadius, 1.f};
-                    speedDown.initialX = prevInitialX;
-                    speedDown.finalX = _lastPoint.x() / xStretch;
-                    _scaledSegments.push_back(speedDown);
-                }
+        for (decltype(size) pair = 0; pair <= size; ++pair) {
+            if (!solvePair(pair)) {
+                // we reduced the radii of the circles, start over
+                done = false;
+                break;
             }
         }
 
         if (done && _autoFlip) {
             // check if we need to flip around some circles
-            for (decltype (size) i = 0; i < size; ++i) {
-                const auto j = i * 2 + 2;
-                if ((_scaledSegments[j].type == SegmentType::Circle) && (_scaledSegments[j].initialX > _scaledSegments[j].finalX)) {
-                    // flip the circle and start over with solving the curve
-                    if (_autoSides[i] == Side::Auto) {
-                        _autoSides[i] = _sides[i] ? Side::ForceFalse : Side::ForceTrue;
-                        done = false;
-                        break;
-                    }
-                }
+            const auto flip = findFlip(0);
+            if (flip < size) {
+                // flip the circle and start over with solving the curve
+                flipCircle(flip);
+                done = false;
             }
         }
         ++_iterations;
     }
+}
 
-    _solveTimeUs = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - startTime).count();
+void EaseCurve::solveFrom(size_t pair)
+{
+    // Starting over after a reduction or a flip solves the pairs before the changed circles again,
+    // with nothing they depend on changed, so stepping back to the first pair with a changed circle
+    // gives the same curve.
+    const auto size = _pointRecords.size();
+    // the circles before it were checked for flipping, with the same segments
+    size_t checkFrom = (pair > 0) ? pair - 1 : 0;
+    while (true) {
+        while (pair <= size) {
+            if (catchUp(pair)) {
+                // the rest is as the last solve left it
+                break;
+            }
+            if (solvePair(pair)) {
+                ++pair;
+                continue;
+            }
+            // we reduced the radii of the circles, place them again and step back to the pair of the left one
+            if (pair == 0 || pair == size) {
+                placeEnds();
+            }
+            if (pair > 0) {
+                placeCircle(pair - 1);
+            }
+            if (pair < size) {
+                placeCircle(pair);
+            }
+            pair = (pair > 0) ? pair - 1 : 0;
+            // the segment of a circle ends on the next pair, so solving a pair changes the one of its left circle
+            checkFrom = std::min(checkFrom, (pair > 0) ? pair - 1 : 0);
+            ++_iterations;
+        }
+
+        const auto flip = _autoFlip ? findFlip(checkFrom) : size;
+        if (flip >= size) {
+            break;
+        }
+        // flip the circle and carry on from its pair
+        flipCircle(flip);
+        placeCircle(flip);
+        pair = flip;
+        checkFrom = (flip > 0) ? flip - 1 : 0;
+        ++_iterations;
+    }
+    ++_iterations;
+}
+
+bool EaseCurve::catchUp(const size_t pair)
+{
+    PreviousTail& tail = _previousTail;
+    const auto size = _pointRecords.size();
+    if (tail.firstPair == 0 || pair < tail.firstPair || pair >= size) {
+        return false;
+    }
+    // Pair solves the same as before, and with its right circle never reduced nor flipped by the
+    // solve before, what that did past it depended on nothing before it either.
+    const size_t offset = pair - tail.firstPair;
+    _scaledSegments.erase(_scaledSegments.begin() + static_cast<std::ptrdiff_t>(pair * 2), _scaledSegments.end());
+    const bool same = _pointRecords[pair].untouched()
+        && _pointRecords[pair - 1].sameCircle(tail.records[offset]) && _pointRecords[pair].sameCircle(tail.records[offset + 1])
+        && _scaledSegments.back().finalX == tail.segments[offset * 2].finalX;
+    if (!same) {
+        if (tail.restoredFrom == pair) {
+            // the circles past it were taken from the tail, solve them from the start after all
+            for (auto i = pair; i < size; ++i) {
+                restartCircle(i);
+            }
+            _lastReducedRadius = _lastRadius;
+            placeEnds();
+            tail.restoredFrom = 0;
+        }
+        return false;
+    }
+    for (auto i = pair + 1; i < size; ++i) {
+        _pointRecords[i].takeSolved(tail.records[offset + 1 + i - pair]);
+    }
+    _scaledLastCenter = tail.lastCenter;
+    _lastReducedRadius = tail.lastReducedRadius;
+    _scaledSegments.insert(_scaledSegments.end(), tail.segments.begin() + static_cast<std::ptrdiff_t>(offset * 2 + 1), tail.segments.end());
+    tail.restoredFrom = pair;
+    return true;
+}
+
+void EaseCurve::placeEnds()
+{
+    _scaledFirstCenter = {{kFirstPoint.x(), kFirstPoint.y() + _firstReducedRadius}};
+    _scaledLastCenter = {{_lastPoint.x() / _xStretch, _lastPoint.y() - _lastReducedRadius}};
+}
+
+void EaseCurve::placeCircle(const size_t index)
+{
+    const auto size = _pointRecords.size();
+    PointRecord& record = _pointRecords[index];
+    const Point prevPoint = unstretch((index == 0) ? kFirstPoint : _pointRecords[index - 1].point);
+    const Point nextPoint = unstretch((index == size - 1) ? _lastPoint : _pointRecords[index + 1].point);
+    const Point currPoint = unstretch(record.point);
+    // Figure out whether the current circle needs to go "above" or "below" the line segments.
+    // In order to figure that out, we need to see whether the angle (ie. slope) of the consecutive segments
+    // increases or decreases.
+    // When the angle increases, the curve "goes up", so the circle needs to be "above"
+    const trig::RadF leftAngle = (currPoint - prevPoint).angle();
+    const trig::RadF rightAngle = (nextPoint - currPoint).angle();
+    const bool above = (record.autoSide == Side::ForceTrue) || ((record.autoSide == Side::Auto) && (rightAngle > leftAngle));
+    const trig::RadF signedPi = above ? trig::Straight<trig::RadF> : -trig::Straight<trig::RadF>;
+    const trig::RadF centerAngle = (leftAngle + rightAngle + signedPi) / 2;
+    record.set(PointRecord::kAbove, above);
+    record.scaledCenter = currPoint + Point::fromPolar(centerAngle, record.reducedRadius);
+}
+
+void EaseCurve::restartCircle(const size_t index)
+{
+    PointRecord& record = _pointRecords[index];
+    record.autoSide = Side::Auto;
+    record.reducedRadius = record.radius;
+    placeCircle(index);
+    record.set(PointRecord::kOriginallyAbove, record.has(PointRecord::kAbove));
+}
+
+bool EaseCurve::solvePair(const size_t pair)
+{
+    const auto size = _pointRecords.size();
+    const bool first = (pair == 0);
+    const bool last = (pair == size);
+
+    const Point leftPoint = unstretch(first ? kFirstPoint : _pointRecords[pair - 1].point);
+    Point& leftCenter = first ? _scaledFirstCenter : _pointRecords[pair - 1].scaledCenter;
+    float& leftRadius = first ? _firstReducedRadius : _pointRecords[pair - 1].reducedRadius;
+    const bool leftSide = first ? true : _pointRecords[pair - 1].has(PointRecord::kAbove);
+    const Point rightPoint = unstretch(last ? _lastPoint : _pointRecords[pair].point);
+    Point& rightCenter = last ? _scaledLastCenter : _pointRecords[pair].scaledCenter;
+    float& rightRadius = last ? _lastReducedRadius : _pointRecords[pair].reducedRadius;
+    const bool rightSide = last ? false : _pointRecords[pair].has(PointRecord::kAbove);
+
+    if (::reduceRadii(*this, leftPoint, leftCenter, leftRadius, leftSide, rightPoint, rightCenter, rightRadius, rightSide)) {
+        return false;
+    }
+
+    // solve for the pair, after the segments of the pairs before it
+    _scaledSegments.erase(_scaledSegments.begin() + static_cast<std::ptrdiff_t>(pair * 2), _scaledSegments.end());
+    const float initialX = first ? 0.f : _scaledSegments.back().finalX;
+    const SolveResult& res = ::solve(initialX, leftCenter, leftRadius, leftSide, rightCenter, rightRadius, rightSide);
+    _scaledSegments.push_back(res.speedUp);
+    _scaledSegments.push_back(res.cruise);
+
+    if (last) {
+        // also add the final segment, corresponding to the circle on the last point
+        Segment speedDown = Circle {_scaledLastCenter, _lastReducedRadius * _lastReducedRadius, 1.f};
+        speedDown.initialX = res.cruise.finalX;
+        speedDown.finalX = _lastPoint.x() / _xStretch;
+        _scaledSegments.push_back(speedDown);
+    }
+    return true;
+}
+
+size_t EaseCurve::findFlip(const size_t first) const
+{
+    const auto size = _pointRecords.size();
+    for (auto i = first; i < size; ++i) {
+        // the accelerating segment of the circle runs backwards
+        const Segment& segment = _scaledSegments[i * 2 + 2];
+        if ((segment.type == SegmentType::Circle) && (segment.initialX > segment.finalX) && (_pointRecords[i].autoSide == Side::Auto)) {
+            return i;
+        }
+    }
+    return size;
+}
+
+void EaseCurve::flipCircle(const size_t index)
+{
+    PointRecord& record = _pointRecords[index];
+    record.autoSide = record.has(PointRecord::kAbove) ? Side::ForceFalse : Side::ForceTrue;
+}
+
+void EaseCurve::buildIndex()
+{
+    _breakpoints.clear();
+    float breakpoint = -std::numeric_limits<float>::infinity();
+    for (const Segment& segment: _scaledSegments) {
+        breakpoint = std::max(breakpoint, segment.finalX);
+        _breakpoints.push_back(breakpoint);
+    }
+    _segmentArrays.clear();
+    for (const Segment& segment: _scaledSegments) {
+        _segmentArrays.push_back(segment);
+    }
+    _segmentArrays.push_back(Line {0.f, 0.f});
 }
 
 
@@ -0,0 +1,60 @@
+module;
+
+export module main.framearena;
+
+import std;
+
+// Scratch memory for one frame: handed out by bumping an offset and taken back all at once by
+// reset(). A frame that runs out borrows from the heap for the rest of it, and the next reset() grows
+// the buffer to that frame's high water mark, so once the frames settle they stop allocating.
+// Only for trivial types, which are never destroyed.
+export struct FrameArena
+{
+    //! count default initialized Ts, valid until the next reset().
+    template <typename T>
+        requires std::is_trivially_copyable_v<T> && std::is_trivially_destructible_v<T>
+    [[nodiscard]] std::span<T> allocate(const size_t count)
+    {
+        static_assert(alignof(T) <= alignof(std::max_align_t));
+        const size_t bytes = count * sizeof(T);
+        const size_t offset = (_used + alignof(T) - 1) / alignof(T) * alignof(T);
+        _used = offset + bytes;
+        _highWater = std::max(_highWater, _used);
+        if (_used <= _buffer.size()) {
+            return spanOf<T>(std::span(_buffer).subspan(offset, bytes).data(), count);
+        }
+        return spanOf<T>(_overflow.emplace_back(std::make_unique_for_overwrite<std::byte[]>(bytes)).get(), count);
+    }
+
+    //! Take back everything handed out, growing the buffer if the frame didn't fit.
+    void reset()
+    {
+        if (_highWater > _buffer.size()) {
+            _buffer.resize(_highWater);
+        }
+        _overflow.clear();
+        _used = 0;
+        _highWater = 0;
+    }
+
+    // internal (private)
+    template <typename T>
+    static std::span<T> spanOf(std::byte* const data, const size_t count)
+    {
+        T* const first = static_cast<T*>(static_cast<void*>(data));
+        std::uninitialized_default_construct_n(first, count);
+#if defined(__clang__)
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wunsafe-buffer-usage"
+#endif
+        return { first, count };
+#if defined(__clang__)
+#pragma clang diagnostic pop
+#endif
+    }
+
+    std::vector<std::byte>                      _buffer         = {};
+    size_t                                      _used           = 0;
+    size_t                                      _highWater      = 0;    // of the frame so far, overflow included
+    std::vector<std::unique_ptr<std::byte[]>>   _overflow       = {};
+};
@@ -0,0 +1,130 @@
+module;
+
+export module main.frameprofiler;
+
+import std;
+
+// Where the time of a frame goes, phase by phase, with the draw work it recorded. The phases are
+// marked in the order frame() runs them; each gets the time since the previous mark.
+export enum class FramePhase
+{
+    Ui,         // building the ImGui windows
+    Solve,      // picking up the latest solve, tessellated by the solver thread
+    Record,     // render() recording the sokol_gp commands, renderCurves() drawing the curves
+    Flush,      // sgp_flush() and sgp_end()
+    ImGui,      // simgui_render()
+    Commit,     // ending the pass and committing it
+    Count,
+};
+export constexpr size_t kFramePhaseCount = static_cast<size_t>(FramePhase::Count);
+
+export constexpr std::array<const char*, kFramePhaseCount> kFramePhaseNames = { "ui", "solve", "record", "flush", "imgui", "commit" };
+
+// The draw work of a frame: the draw calls, the vertices they draw and the vertices uploaded for
+// them, which the vertex buffers kept on the GPU save, and the heap allocations made while recording
+// them, which should stay at zero once the frame arena has grown.
+export struct DrawCounters
+{
+    std::uint32_t           drawCommands        = 0;
+    std::uint32_t           vertices            = 0;
+    std::uint32_t           uploadedVertices    = 0;
+    std::uint32_t           heapAllocations     = 0;
+
+    DrawCounters& operator+=(const DrawCounters& other)
+    {
+        drawCommands += other.drawCommands;
+        vertices += other.vertices;
+        uploadedVertices += other.uploadedVertices;
+        heapAllocations += other.heapAllocations;
+        return *this;
+    }
+};
+
+export struct FrameSample
+{
+    std::array<float, kFramePhaseCount> phaseMs = {};
+    float                   totalMs             = 0;
+    DrawCounters            draws               = {};
+};
+
+export struct FrameProfiler
+{
+    static constexpr size_t kHistory = 240;
+
+    void beginFrame()
+    {
+        _current = {};
+        _frameStart = _lastMark = std::chrono::steady_clock::now();
+    }
+
+    //! Charge the time since the previous mark to phase.
+    void mark(const FramePhase phase)
+    {
+        const auto now = std::chrono::steady_clock::now();
+        _current.phaseMs[static_cast<size_t>(phase)] += milliseconds(now - _lastMark);
+        _lastMark = now;
+    }
+
+    void endFrame(const DrawCounters draws)
+    {
+        _current.totalMs = milliseconds(std::chrono::steady_clock::now() - _frameStart);
+        _current.draws = draws;
+        _history[_next] = _current;
+        _next = (_next + 1) % kHistory;
+        if (_csv.is_open()) {
+            writeCsvRow(_current);
+        }
+        ++_frame;
+    }
+
+    //! The recorded frames, oldest first.
+    template <typename Func>
+    void forEachFrame(Func&& func) const
+    {
+        for (size_t index = 0; index < kHistory; ++index) {
+            func(_history[(_next + index) % kHistory]);
+        }
+    }
+    [[nodiscard]] const FrameSample& last() const { return _history[(_next + kHistory - 1) % kHistory]; }
+
+    //! Append a row per frame to a CSV file from now on. On failure error says why.
+    [[nodiscard]] bool startCsv(const std::filesystem::path& fileName, std::string& error)
+    {
+        _csv.open(fileName);
+        if (!_csv) {
+            error = std::format("can't create {}", fileName.string());
+            return false;
+        }
+        std::print(_csv, "frame");
+        for (const char* name : kFramePhaseNames) {
+            std::print(_csv, ",{}_ms", name);
+        }
+        std::println(_csv, ",total_ms,draw_commands,vertices,uploaded_vertices,heap_allocations");
+        return true;
+    }
+    void stopCsv() { _csv.close(); }
+    [[nodiscard]] bool csvEnabled() const { return _csv.is_open(); }
+
+    // internal (private)
+    static float milliseconds(const std::chrono::steady_clock::duration duration)
+    {
+        return std::chrono::duration<float, std::milli>(duration).count();
+    }
+
+    void writeCsvRow(const FrameSample& sample)
+    {
+        std::print(_csv, "{}", _frame);
+        for (const float ms : sample.phaseMs) {
+            std::print(_csv, ",{:.4f}", ms);
+        }
+        std::println(_csv, ",{:.4f},{},{},{},{}", sample.totalMs, sample.draws.drawCommands, sample.draws.vertices, sample.draws.uploadedVertices, sample.draws.heapAllocations);
+    }
+
+    std::array<FrameSample, kHistory>       _history        = {};   // a ring, oldest at _next
+    size_t                                  _next           = 0;
+    size_t                                  _frame          = 0;
+    FrameSample                             _current        = {};
+    std::chrono::steady_clock::time_point   _frameStart     = {};
+    std::chrono::steady_clock::time_point   _lastMark       = {};
+    std::ofstream                           _csv            = {};
+};
@@ -0,0 +1,288 @@
+module;
+
+#include "alx/rassert.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+module main.pathfile;
+
+import alx.assert;
+
+namespace {
+
+// Mapped memory as records of T; the only place the layout of a file is taken on trust.
+template <typename T>
+std::span<const T> spanOf(const void* const data, const size_t count)
+{
+    R_ASSERT(reinterpret_cast<std::uintptr_t>(data) % alignof(T) == 0);
+#if defined(__clang__)
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wunsafe-buffer-usage"
+#endif
+    return { static_cast<const T*>(data), count };
+#if defined(__clang__)
+#pragma clang diagnostic pop
+#endif
+}
+
+std::span<const std::byte> mapFile(const std::filesystem::path& fileName, std::string& error)
+{
+#if defined(_WIN32)
+    const HANDLE file = CreateFileW(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        error = std::format("can't open {}", fileName.string());
+        return {};
+    }
+    LARGE_INTEGER fileSize = {};
+    const bool sized = GetFileSizeEx(file, &fileSize) && fileSize.QuadPart > 0;
+    const HANDLE mapping = sized ? CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+    CloseHandle(file);
+    // the view keeps the file mapped after both handles are closed
+    void* const data = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (mapping) {
+        CloseHandle(mapping);
+    }
+    if (!data) {
+        error = std::format("can't map {}", fileName.string());
+        return {};
+    }
+    const size_t size = static_cast<size_t>(fileSize.QuadPart);
+#else
+    const int file = ::open(fileName.c_str(), O_RDONLY | O_CLOEXEC);
+    if (file < 0) {
+        error = std::format("can't open {}", fileName.string());
+        return {};
+    }
+    struct stat info = {};
+    const bool sized = ::fstat(file, &info) == 0 && info.st_size > 0;
+    const size_t size = sized ? static_cast<size_t>(info.st_size) : 0;
+    void* const data = sized ? ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0) : MAP_FAILED;
+    ::close(file);
+    if (data == MAP_FAILED) {
+        error = std::format("can't map {}", fileName.string());
+        return {};
+    }
+#endif
+    return spanOf<std::byte>(data, size);
+}
+
+void unmapFile(const std::span<const std::byte> bytes)
+{
+#if defined(_WIN32)
+    UnmapViewOfFile(bytes.data());
+#else
+    ::munmap(const_cast<std::byte*>(bytes.data()), bytes.size());
+#endif
+}
+
+// Carves count records of T off the front of bytes, or fails when the file is too short for them.
+template <typename T>
+bool takeSection(std::span<const std::byte>& bytes, const std::uint64_t count, std::span<const T>& section)
+{
+    if (count > bytes.size() / sizeof(T)) {
+        return false;
+    }
+    const size_t size = static_cast<size_t>(count) * sizeof(T);
+    section = spanOf<T>(bytes.data(), static_cast<size_t>(count));
+    // the next section starts 16 byte aligned
+    bytes = bytes.subspan(std::min(bytes.size(), (size + 15) & ~size_t { 15 }));
+    return true;
+}
+
+template <typename T>
+void writeValue(std::ostream& out, const T& value)
+{
+    out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+void writeValues(std::ostream& out, const std::span<const T> values)
+{
+    out.write(reinterpret_cast<const char*>(values.data()), static_cast<std::streamsize>(values.size_bytes()));
+}
+
+void writePadding(std::ostream& out, const size_t size)
+{
+    constexpr std::array<char, 16> zeros = {};
+    out.write(zeros.data(), static_cast<std::streamsize>((16 - size % 16) % 16));
+}
+
+} // namespace
+
+Path PathView::toPath() const
+{
+    return {
+        .startTime                  = record.startTime,
+        .startProgress              = record.startProgress,
+        .startVelocity              = record.startVelocity,
+        .startEaseDuration          = record.startEaseDuration,
+        .endTime                    = record.endTime,
+        .endProgress                = record.endProgress,
+        .endVelocity                = record.endVelocity,
+        .endEaseDuration            = record.endEaseDuration,
+        .checkpoints                = { checkpoints.begin(), checkpoints.end() },
+        .adjustedStartEaseDuration  = record.adjustedStartEaseDuration,
+        .adjustedEndEaseDuration    = record.adjustedEndEaseDuration,
+    };
+}
+
+void PathView::toPath(Path& path) const
+{
+    path.startTime                  = record.startTime;
+    path.startProgress              = record.startProgress;
+    path.startVelocity              = record.startVelocity;
+    path.startEaseDuration          = record.startEaseDuration;
+    path.endTime                    = record.endTime;
+    path.endProgress                = record.endProgress;
+    path.endVelocity                = record.endVelocity;
+    path.endEaseDuration            = record.endEaseDuration;
+    path.checkpoints.assign(checkpoints.begin(), checkpoints.end());
+    path.adjustedStartEaseDuration  = record.adjustedStartEaseDuration;
+    path.adjustedEndEaseDuration    = record.adjustedEndEaseDuration;
+}
+
+MappedPathFile::MappedPathFile(MappedPathFile&& other) noexcept
+    : _bytes(std::exchange(other._bytes, {}))
+    , _records(std::exchange(other._records, {}))
+    , _checkpoints(std::exchange(other._checkpoints, {}))
+    , _velocities(std::exchange(other._velocities, {}))
+    , _hasVelocities(std::exchange(other._hasVelocities, false))
+{
+}
+
+MappedPathFile& MappedPathFile::operator=(MappedPathFile&& other) noexcept
+{
+    if (this != &other) {
+        close();
+        _bytes          = std::exchange(other._bytes, {});
+        _records        = std::exchange(other._records, {});
+        _checkpoints    = std::exchange(other._checkpoints, {});
+        _velocities     = std::exchange(other._velocities, {});
+        _hasVelocities  = std::exchange(other._hasVelocities, false);
+    }
+    return *this;
+}
+
+bool MappedPathFile::open(const std::filesystem::path& fileName, std::string& error)
+{
+    close();
+    _bytes = mapFile(fileName, error);
+    if (_bytes.empty()) {
+        return false;
+    }
+    auto fail = [&](const std::string_view reason) {
+        error = std::format("{}: {}", fileName.string(), reason);
+        close();
+        return false;
+    };
+
+    std::span<const std::byte> rest = _bytes;
+    std::span<const PathFileHeader> header;
+    if (!takeSection(rest, 1, header) || header[0].magic != kPathFileMagic) {
+        return fail("not a path file");
+    }
+    if (header[0].version == 0) {
+        return fail("version 0 is not a valid version");
+    }
+    if (header[0].version > kPathFileVersion) {
+        return fail(std::format("version {} is newer than the supported {}", header[0].version, kPathFileVersion));
+    }
+    _hasVelocities = (header[0].flags & kPathFileVelocities) != 0;
+    if (!takeSection(rest, header[0].pathCount, _records)
+        || !takeSection(rest, header[0].checkpointCount, _checkpoints)
+        || !takeSection(rest, _hasVelocities ? header[0].velocityCount : 0, _velocities)) {
+        return fail("truncated");
+    }
+    for (const PathRecord& record : _records) {
+        const bool checkpointsFit = record.firstCheckpoint <= _checkpoints.size() && record.checkpointCount <= _checkpoints.size() - record.firstCheckpoint;
+        const bool velocitiesFit = !_hasVelocities || (record.firstVelocity <= _velocities.size() && record.checkpointCount < _velocities.size() - record.firstVelocity);
+        if (!checkpointsFit || !velocitiesFit) {
+            return fail("path out of range");
+        }
+    }
+    return true;
+}
+
+void MappedPathFile::close()
+{
+    if (!_bytes.empty()) {
+        unmapFile(_bytes);
+    }
+    _bytes          = {};
+    _records        = {};
+    _checkpoints    = {};
+    _velocities     = {};
+    _hasVelocities  = false;
+}
+
+PathView MappedPathFile::path(const size_t index) const
+{
+    const PathRecord& record = _records[index];
+    const size_t checkpointCount = static_cast<size_t>(record.checkpointCount);
+    return {
+        .record         = record,
+        .checkpoints    = _checkpoints.subspan(static_cast<size_t>(record.firstCheckpoint), checkpointCount),
+        .velocities     = _hasVelocities ? _velocities.subspan(static_cast<size_t>(record.firstVelocity), checkpointCount + 1) : std::span<const float> {},
+    };
+}
+
+bool writePathFile(const std::filesystem::path& fileName, const std::span<const Path> paths, const std::span<const float> velocities, std::string& error)
+{
+    PathFileHeader header { .pathCount = paths.size() };
+    for (const Path& path : paths) {
+        header.checkpointCount += path.checkpoints.size();
+    }
+    if (!velocities.empty()) {
+        R_ASSERT(velocities.size() == header.checkpointCount + paths.size());
+        header.flags |= kPathFileVelocities;
+        header.velocityCount = velocities.size();
+    }
+
+    std::ofstream out(fileName, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        error = std::format("can't create {}", fileName.string());
+        return false;
+    }
+    writeValue(out, header);
+    std::uint64_t firstCheckpoint = 0;
+    for (size_t index = 0; index < paths.size(); ++index) {
+        const Path& path = paths[index];
+        const PathRecord record {
+            .startTime                  = path.startTime,
+            .startProgress              = path.startProgress,
+            .startVelocity              = path.startVelocity,
+            .startEaseDuration          = path.startEaseDuration,
+            .endTime                    = path.endTime,
+            .endProgress                = path.endProgress,
+            .endVelocity                = path.endVelocity,
+            .endEaseDuration            = path.endEaseDuration,
+            .adjustedStartEaseDuration  = path.adjustedStartEaseDuration,
+            .adjustedEndEaseDuration    = path.adjustedEndEaseDuration,
+            .firstCheckpoint            = firstCheckpoint,
+            .checkpointCount            = path.checkpoints.size(),
+            .firstVelocity              = velocities.empty() ? 0 : firstCheckpoint + index,
+        };
+        writeValue(out, record);
+        firstCheckpoint += path.checkpoints.size();
+    }
+    for (const Path& path : paths) {
+        writeValues(out, std::span<const Checkpoint>(path.checkpoints));
+    }
+    writePadding(out, static_cast<size_t>(header.checkpointCount) * sizeof(Checkpoint));
+    writeValues(out, velocities);
+
+    if (!out.flush()) {
+        error = std::format("can't write {}", fileName.string());
+        return false;
+    }
+    return true;
+}
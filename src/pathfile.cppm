@@ -0,0 +1,97 @@
+module;
+
+export module main.pathfile;
+
+import std;
+
+import main.solver;
+
+// Binary path files. Everything is little-endian, and every section starts 16 byte aligned, so the
+// checkpoints and velocities of a mapped file are used in place:
+//
+//     PathFileHeader
+//     PathRecord      [pathCount]
+//     Checkpoint      [checkpointCount]       time, progress, easeDuration, adjustedEaseDuration
+//     float           [velocityCount]         with kPathFileVelocities, checkpoints + 1 per path
+//
+// Readers reject files with a newer version, and check every range before handing out views.
+export constexpr std::array<char, 8>    kPathFileMagic          = { 'E', 'A', 'S', 'E', 'P', 'A', 'T', 'H' };
+export constexpr std::uint32_t          kPathFileVersion        = 1;
+export constexpr std::uint32_t          kPathFileVelocities     = 0x1;  // solved velocities follow the checkpoints
+
+export struct PathFileHeader
+{
+    std::array<char, 8>     magic                       = kPathFileMagic;
+    std::uint32_t           version                     = kPathFileVersion;
+    std::uint32_t           flags                       = 0;
+    std::uint64_t           pathCount                   = 0;
+    std::uint64_t           checkpointCount             = 0;
+    std::uint64_t           velocityCount               = 0;
+    std::uint64_t           reserved                    = 0;
+};
+
+export struct PathRecord
+{
+    float                   startTime                   = 0;
+    float                   startProgress               = 0;
+    float                   startVelocity               = 0;
+    float                   startEaseDuration           = 0;
+    float                   endTime                     = 0;
+    float                   endProgress                 = 0;
+    float                   endVelocity                 = 0;
+    float                   endEaseDuration             = 0;
+    float                   adjustedStartEaseDuration   = 0;
+    float                   adjustedEndEaseDuration     = 0;
+    std::uint64_t           firstCheckpoint             = 0;
+    std::uint64_t           checkpointCount             = 0;
+    std::uint64_t           firstVelocity               = 0;    // checkpointCount + 1 of them
+};
+
+// The mapped files are the in-memory layout, which holds on the platforms we build for.
+static_assert(std::endian::native == std::endian::little);
+static_assert(std::numeric_limits<float>::is_iec559);
+static_assert(sizeof(PathFileHeader) == 48 && std::is_trivially_copyable_v<PathFileHeader>);
+static_assert(sizeof(PathRecord) == 64 && std::is_trivially_copyable_v<PathRecord>);
+static_assert(sizeof(Checkpoint) == 16 && std::is_trivially_copyable_v<Checkpoint>);
+
+// One path of a mapped file, without copying its checkpoints.
+export struct PathView
+{
+    PathRecord                      record          = {};
+    std::span<const Checkpoint>     checkpoints     = {};
+    std::span<const float>          velocities      = {};   // empty when the file has none
+
+    //! A Path for the solver, with its own copy of the checkpoints.
+    [[nodiscard]] Path toPath() const;
+    //! Same, into an existing path, reusing its checkpoint buffer.
+    void toPath(Path& path) const;
+};
+
+// A path file mapped read-only into memory. Opening only checks the header and the path records, the
+// checkpoint pages are read when a view touches them.
+export struct MappedPathFile
+{
+    MappedPathFile() = default;
+    MappedPathFile(MappedPathFile&& other) noexcept;
+    MappedPathFile& operator=(MappedPathFile&& other) noexcept;
+    ~MappedPathFile() { close(); }
+
+    //! Map a file and check its layout. On failure the file is left closed and error says why.
+    [[nodiscard]] bool open(const std::filesystem::path& fileName, std::string& error);
+    void close();
+
+    [[nodiscard]] size_t pathCount() const { return _records.size(); }
+    [[nodiscard]] bool hasVelocities() const { return _hasVelocities; }
+    [[nodiscard]] PathView path(size_t index) const;
+
+    // internal (private)
+    std::span<const std::byte>      _bytes          = {};
+    std::span<const PathRecord>     _records        = {};
+    std::span<const Checkpoint>     _checkpoints    = {};
+    std::span<const float>          _velocities     = {};
+    bool                            _hasVelocities  = false;
+};
+
+// Writes the paths with their adjusted ease durations and, when velocities isn't empty, their solved
+// velocities: checkpoints.size() + 1 per path, back to back, as in BatchSolution::velocities.
+export [[nodiscard]] bool writePathFile(const std::filesystem::path& fileName, std::span<const Path> paths, std::span<const float> velocities, std::string& error);
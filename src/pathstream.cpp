@@ -0,0 +1,196 @@
+module main.pathstream;
+
+import alx.va;
+
+namespace va = alx::va;
+
+namespace {
+
+void writeCurve(std::ostream& out, const std::string_view name, const std::vector<va::Vec2f>& curve)
+{
+    std::print(out, "{}", name);
+    for (const va::Vec2f point : curve) {
+        std::print(out, " {} {}", point.x(), point.y());
+    }
+    std::println(out, "");
+}
+
+void writeValues(std::ostream& out, const std::string_view name, const std::span<const float> values)
+{
+    std::print(out, "{}", name);
+    for (const float value : values) {
+        std::print(out, " {}", value);
+    }
+    std::println(out, "");
+}
+
+// The whitespace separated fields of a line, read in place.
+struct Fields
+{
+    static constexpr std::string_view kSpace = " \t\r\f\v";
+
+    std::string_view                rest;
+
+    //! The next field, empty past the last one.
+    std::string_view next()
+    {
+        const size_t start = std::min(rest.find_first_not_of(kSpace), rest.size());
+        rest.remove_prefix(start);
+        const size_t end = std::min(rest.find_first_of(kSpace), rest.size());
+        const std::string_view field = rest.substr(0, end);
+        rest.remove_prefix(end);
+        return field;
+    }
+
+    //! Parse the next field as a number, false if it's missing or isn't one throughout.
+    bool read(float& value)
+    {
+        const std::string_view field = next();
+        const char* const last = std::to_address(field.end());
+        const auto [end, error] = std::from_chars(std::to_address(field.begin()), last, value);
+        return !field.empty() && error == std::errc {} && end == last;
+    }
+};
+
+} // namespace
+
+bool validatePath(const Path& path)
+{
+    float prevTime = path.startTime;
+    float prevProgress = path.startProgress;
+    for (const Checkpoint& checkpoint : path.checkpoints) {
+        if (checkpoint.time <= prevTime || checkpoint.progress <= prevProgress || checkpoint.easeDuration < 0.f) {
+            return false;
+        }
+        prevTime = checkpoint.time;
+        prevProgress = checkpoint.progress;
+    }
+    return path.endTime > prevTime && path.endProgress > prevProgress && path.startEaseDuration >= 0.f && path.endEaseDuration >= 0.f;
+}
+
+bool adjustedEasesFit(const Path& path)
+{
+    float prevTime = path.startTime;
+    float prevEaseDuration = path.adjustedStartEaseDuration;
+    if (prevEaseDuration < 0.f) {
+        return false;
+    }
+    for (const Checkpoint& checkpoint : path.checkpoints) {
+        if (checkpoint.adjustedEaseDuration < 0.f || checkpoint.time - prevTime < prevEaseDuration + checkpoint.adjustedEaseDuration / 2) {
+            return false;
+        }
+        prevTime = checkpoint.time;
+        prevEaseDuration = checkpoint.adjustedEaseDuration / 2;
+    }
+    return path.adjustedEndEaseDuration >= 0.f && path.endTime - prevTime >= prevEaseDuration + path.adjustedEndEaseDuration;
+}
+
+bool PathReader::next(Path& path)
+{
+    if (!_error.empty()) {
+        return false;
+    }
+    if (!_headerAhead) {
+        switch (readRecord()) {
+        case Record::End:
+        case Record::Bad:
+            return false;
+        case Record::Checkpoint:
+            return fail("checkpoint before any path");
+        case Record::Path:
+            break;
+        }
+    }
+    _headerAhead = false;
+
+    path.startTime          = _header.startTime;
+    path.startProgress      = _header.startProgress;
+    path.startVelocity      = _header.startVelocity;
+    path.startEaseDuration  = _header.startEaseDuration;
+    path.endTime            = _header.endTime;
+    path.endProgress        = _header.endProgress;
+    path.endVelocity        = _header.endVelocity;
+    path.endEaseDuration    = _header.endEaseDuration;
+    path.checkpoints.clear();
+    // the path ends where the next one starts
+    for (bool reading = true; reading;) {
+        switch (readRecord()) {
+        case Record::Bad:
+            return false;
+        case Record::End:
+            reading = false;
+            break;
+        case Record::Path:
+            _headerAhead = true;
+            reading = false;
+            break;
+        case Record::Checkpoint:
+            path.checkpoints.push_back(_checkpoint);
+            break;
+        }
+    }
+    if (!validatePath(path)) {
+        return fail(std::format("path {} is not increasing in time and progress", _pathIndex));
+    }
+    ++_pathIndex;
+    return true;
+}
+
+PathReader::Record PathReader::readRecord()
+{
+    while (std::getline(_in, _line)) {
+        ++_lineNumber;
+        // parsed in place, without copying the line
+        Fields fields { std::string_view(_line).substr(0, _line.find('#')) };
+        const std::string_view record = fields.next();
+        if (record.empty()) {
+            continue;
+        }
+        Record result = Record::Bad;
+        bool read = false;
+        if (record == "path") {
+            _header = {};
+            read = fields.read(_header.startTime) && fields.read(_header.startProgress) && fields.read(_header.startVelocity) && fields.read(_header.startEaseDuration)
+                && fields.read(_header.endTime) && fields.read(_header.endProgress) && fields.read(_header.endVelocity) && fields.read(_header.endEaseDuration);
+            result = Record::Path;
+        } else if (record == "checkpoint") {
+            _checkpoint = {};
+            read = fields.read(_checkpoint.time) && fields.read(_checkpoint.progress) && fields.read(_checkpoint.easeDuration);
+            result = Record::Checkpoint;
+        } else {
+            fail(std::format("unexpected '{}'", record));
+            return Record::Bad;
+        }
+        if (!read || !fields.next().empty()) {
+            fail(std::format("bad {} record", record));
+            return Record::Bad;
+        }
+        return result;
+    }
+    if (_in.bad()) {
+        fail("read error");
+        return Record::Bad;
+    }
+    return Record::End;
+}
+
+bool PathReader::fail(const std::string_view reason)
+{
+    _error = std::format("{}:{}: {}", _name, _lineNumber, reason);
+    return false;
+}
+
+void SolvedPathWriter::write(const BatchSolution& solution, const size_t index, const size_t progressSamples)
+{
+    std::println(_out, "path {} steps {} error {}", _pathIndex++, solution.steps[index], solution.errors[index]);
+    writeValues(_out, "velocities", solution.pathVelocities(index));
+    if (progressSamples > 0) {
+        writeValues(_out, "samples", solution.pathProgress(index, progressSamples));
+    }
+    if (!solution.tessellated.empty()) {
+        const Result& result = solution.tessellated[index];
+        writeCurve(_out, "progress", result.tessellatedProgress);
+        writeCurve(_out, "velocity", result.tessellatedVelocity);
+        writeCurve(_out, "accel", result.tessellatedAccel);
+    }
+}
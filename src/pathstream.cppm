@@ -0,0 +1,69 @@
+module;
+
+export module main.pathstream;
+
+import std;
+
+import main.solver;
+
+// Text path records, read and written one path at a time so inputs of any size pass through in
+// bounded memory. One record per line, '#' starts a comment, checkpoints belong to the path above:
+//
+//     path <startTime> <startProgress> <startVelocity> <startEaseDuration> <endTime> <endProgress> <endVelocity> <endEaseDuration>
+//     checkpoint <time> <progress> <easeDuration>
+//
+// The solved output, per path:
+//
+//     path <index> steps <count> error <totalErrorAbs>
+//     velocities <v> ...
+//     samples <progress> ...                       progress at evenly spaced times, start to end
+//     progress|velocity|accel <time> <value> ...   the tessellated curves
+
+//! Whether the path increases in time and progress, as the solver asserts.
+export bool validatePath(const Path& path);
+//! Whether the adjusted eases fit between the checkpoints of a valid path, as the solver asserts. Eases
+//! adjusted by adjustEaseDurationsP() do; ones read back from a file may not.
+export bool adjustedEasesFit(const Path& path);
+
+export struct PathReader
+{
+    PathReader(std::istream& in, std::string name) : _in(in), _name(std::move(name)) {}
+
+    //! Read the next path, reusing the checkpoint buffer of path. False at the end of the input or on
+    //! bad input, with error() saying which.
+    [[nodiscard]] bool next(Path& path);
+    [[nodiscard]] const std::string& error() const { return _error; }
+
+    // internal (private)
+    enum class Record
+    {
+        End,
+        Path,
+        Checkpoint,
+        Bad,
+    };
+    Record readRecord();
+    bool fail(std::string_view reason);
+
+    std::istream&                   _in;
+    std::string                     _name;
+    std::string                     _line           = {};
+    size_t                          _lineNumber     = 0;
+    size_t                          _pathIndex      = 0;
+    Path                            _header         = {};   // the last path record, without checkpoints
+    Checkpoint                      _checkpoint     = {};   // the last checkpoint record
+    bool                            _headerAhead    = false; // read the next path's record while looking for checkpoints
+    std::string                     _error          = {};
+};
+
+export struct SolvedPathWriter
+{
+    explicit SolvedPathWriter(std::ostream& out) : _out(out) {}
+
+    //! Write one path of a solved batch, numbered after the paths written before it.
+    void write(const BatchSolution& solution, size_t index, size_t progressSamples);
+
+    // internal (private)
+    std::ostream&                   _out;
+    size_t                          _pathIndex      = 0;
+};
@@ -0,0 +1,181 @@
+module main.profile;
+
+namespace {
+
+constexpr std::array<const char*, kMetricCount> kMetricNames = {
+    "adjust rounds",
+    "refine iterations",
+    "solve time (us)",
+    "tessellate time (us)",
+    "points emitted",
+    "bytes allocated",
+};
+
+const std::chrono::steady_clock::time_point kClockStart = std::chrono::steady_clock::now();
+
+// atomic, as the app's threads may start before it installs them
+constinit std::atomic<std::uint64_t (*)()> sAllocatedBytes = nullptr;
+constinit std::atomic<std::uint64_t (*)()> sAllocationCount = nullptr;
+
+// Small, stable ids for the trace, in the order the threads first record something.
+std::uint32_t threadIndex()
+{
+    static std::atomic<std::uint32_t> nextIndex = 0;
+    thread_local const std::uint32_t index = nextIndex.fetch_add(1, std::memory_order_relaxed);
+    return index;
+}
+
+double microseconds(const std::int64_t ns)
+{
+    return static_cast<double>(ns) / 1e3;
+}
+
+} // namespace
+
+const char* metricName(const Metric metric)
+{
+    return kMetricNames[static_cast<size_t>(metric)];
+}
+
+void Profiler::record(const TraceEvent& event)
+{
+    const std::lock_guard lock(_mutex);
+    if (_events.size() < kMaxEvents) {
+        _events.push_back(event);
+    } else {
+        _events[_nextEvent] = event;
+    }
+    _nextEvent = (_nextEvent + 1) % kMaxEvents;
+}
+
+void Profiler::sample(const Metric metric, const float value)
+{
+    const TraceEvent event {
+        .name       = metricName(metric),
+        .startNs    = profileNow(),
+        .durationNs = -1,
+        .bytes      = static_cast<std::uint64_t>(std::max(value, 0.f)),
+        .thread     = threadIndex(),
+    };
+    record(event);
+
+    const std::lock_guard lock(_mutex);
+    MetricHistory& history = _metrics[static_cast<size_t>(metric)];
+    history.values[history.next] = value;
+    history.next = (history.next + 1) % kMetricHistory;
+    history.last = value;
+    history.max = *std::ranges::max_element(history.values);
+}
+
+MetricHistory Profiler::history(const Metric metric) const
+{
+    const std::lock_guard lock(_mutex);
+    return _metrics[static_cast<size_t>(metric)];
+}
+
+void Profiler::clear()
+{
+    const std::lock_guard lock(_mutex);
+    _events.clear();
+    _nextEvent = 0;
+    _metrics = {};
+}
+
+bool Profiler::writeChromeTrace(const std::filesystem::path& fileName, std::string& error) const
+{
+    std::ofstream out(fileName);
+    if (!out) {
+        error = std::format("can't create {}", fileName.string());
+        return false;
+    }
+
+    const std::lock_guard lock(_mutex);
+    std::println(out, "{{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+    // oldest first, once the ring wrapped around
+    const size_t first = _events.size() < kMaxEvents ? 0 : _nextEvent;
+    for (size_t index = 0; index < _events.size(); ++index) {
+        const TraceEvent& event = _events[(first + index) % _events.size()];
+        const std::string_view separator = index + 1 < _events.size() ? "," : "";
+        if (event.durationNs < 0) {
+            std::println(out, R"({{"name":"{}","ph":"C","ts":{:.3f},"pid":1,"tid":{},"args":{{"value":{}}}}}{})",
+                         event.name, microseconds(event.startNs), event.thread, event.bytes, separator);
+        } else {
+            std::println(out, R"({{"name":"{}","ph":"X","ts":{:.3f},"dur":{:.3f},"pid":1,"tid":{},"args":{{"bytes":{}}}}}{})",
+                         event.name, microseconds(event.startNs), microseconds(event.durationNs), event.thread, event.bytes, separator);
+        }
+    }
+    std::println(out, "]}}");
+
+    out.flush();
+    if (!out) {
+        error = std::format("can't write {}", fileName.string());
+        return false;
+    }
+    return true;
+}
+
+void setAllocationCounters(const AllocationCounters counters)
+{
+    sAllocatedBytes.store(counters.bytes, std::memory_order_relaxed);
+    sAllocationCount.store(counters.count, std::memory_order_relaxed);
+}
+
+std::uint64_t threadAllocatedBytes()
+{
+    const auto bytes = sAllocatedBytes.load(std::memory_order_relaxed);
+    return bytes ? bytes() : 0;
+}
+
+std::uint64_t threadAllocationCount()
+{
+    const auto count = sAllocationCount.load(std::memory_order_relaxed);
+    return count ? count() : 0;
+}
+
+Profiler& profiler()
+{
+    static Profiler instance;
+    return instance;
+}
+
+std::int64_t profileNow()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - kClockStart).count();
+}
+
+ProfileScope::ProfileScope(const char* name, const Metric timeMetric, const Metric bytesMetric)
+    : _name(name)
+    , _timeMetric(timeMetric)
+    , _bytesMetric(bytesMetric)
+    , _enabled(profiler().enabled())
+{
+    if (_enabled) {
+        _startBytes = threadAllocatedBytes();
+        _startNs = profileNow();
+    }
+}
+
+ProfileScope::~ProfileScope()
+{
+    if (!_enabled) {
+        return;
+    }
+    const std::int64_t durationNs = profileNow() - _startNs;
+    const std::uint64_t bytes = threadAllocatedBytes() - _startBytes;
+    Profiler& instance = profiler();
+    instance.record({ .name = _name, .startNs = _startNs, .durationNs = durationNs, .bytes = bytes, .thread = threadIndex() });
+    if (_timeMetric != Metric::None) {
+        instance.sample(_timeMetric, static_cast<float>(microseconds(durationNs)));
+    }
+    if (_bytesMetric != Metric::None) {
+        instance.sample(_bytesMetric, static_cast<float>(bytes));
+    }
+}
+
+void profileSample(const Metric metric, const float value)
+{
+    Profiler& instance = profiler();
+    if (instance.enabled()) {
+        instance.sample(metric, value);
+    }
+}
@@ -0,0 +1,112 @@
+module;
+
+export module main.profile;
+
+import std;
+
+// Low overhead instrumentation of the solver. Scoped timers record trace events, and per solve
+// measurements go into a rolling history per metric, for the app to plot. Both are kept only while
+// the profiler is enabled; disabled, a scope costs a relaxed load. The recorded events are written
+// as Chrome trace JSON, for chrome://tracing or Perfetto.
+
+export enum class Metric
+{
+    AdjustRounds,       // rounds of adjustEaseDurationsP()
+    RefineIterations,   // solver steps past the seed
+    SolveTime,          // in microseconds, once per request for both variants
+    TessellateTime,     // in microseconds
+    PointsEmitted,      // tessellated points of all three curves
+    BytesAllocated,     // by the thread of the scope, during it
+    None,
+};
+export constexpr size_t kMetricCount = static_cast<size_t>(Metric::None);
+
+export [[nodiscard]] const char* metricName(Metric metric);
+
+// The last kMetricHistory samples of a metric, oldest at next.
+export constexpr size_t kMetricHistory = 128;
+export struct MetricHistory
+{
+    std::array<float, kMetricHistory>   values      = {};
+    size_t                              next        = 0;
+    float                               last        = 0;
+    float                               max         = 0;    // of the values held
+};
+
+// A finished scope (a complete event) or a metric sample (a counter event). Names must outlive the
+// profiler, string literals do.
+export struct TraceEvent
+{
+    const char*             name                = nullptr;
+    std::int64_t            startNs             = 0;
+    std::int64_t            durationNs          = 0;    // -1 for a counter
+    std::uint64_t           bytes               = 0;    // the value, for a counter
+    std::uint32_t           thread              = 0;
+};
+
+export struct Profiler
+{
+    static constexpr size_t kMaxEvents = size_t { 1 } << 16;   // then the oldest are dropped
+
+    void setEnabled(const bool enabled) { _enabled.store(enabled, std::memory_order_relaxed); }
+    [[nodiscard]] bool enabled() const { return _enabled.load(std::memory_order_relaxed); }
+
+    void record(const TraceEvent& event);
+    //! Add a sample to the history of a metric, and to the trace as a counter.
+    void sample(Metric metric, float value);
+    [[nodiscard]] MetricHistory history(Metric metric) const;
+    void clear();
+
+    //! Write the recorded events as Chrome trace JSON. On failure error says why.
+    [[nodiscard]] bool writeChromeTrace(const std::filesystem::path& fileName, std::string& error) const;
+
+    // internal (private)
+    std::atomic<bool>                               _enabled    = false;
+    mutable std::mutex                              _mutex      = {};
+    std::vector<TraceEvent>                         _events     = {};   // a ring once full
+    size_t                                          _nextEvent  = 0;
+    std::array<MetricHistory, kMetricCount>         _metrics    = {};
+};
+
+//! The process wide profiler.
+export Profiler& profiler();
+
+//! Nanoseconds since the profiler's clock started, on first use.
+export std::int64_t profileNow();
+
+// The per thread allocation counts of an executable that replaces operator new to keep them, as the
+// app does. The solver library doesn't, so that it links into any program.
+export struct AllocationCounters
+{
+    std::uint64_t           (*bytes)()          = nullptr;
+    std::uint64_t           (*count)()          = nullptr;
+};
+
+//! Install the counters, at startup.
+export void setAllocationCounters(AllocationCounters counters);
+
+//! Bytes the calling thread allocated through operator new so far, 0 without counters.
+export std::uint64_t threadAllocatedBytes();
+//! Same, counting the allocations.
+export std::uint64_t threadAllocationCount();
+
+// Times the rest of the enclosing block as a trace event. Optionally samples its duration and the
+// bytes its thread allocated into metrics.
+export struct ProfileScope
+{
+    explicit ProfileScope(const char* name, Metric timeMetric = Metric::None, Metric bytesMetric = Metric::None);
+    ~ProfileScope();
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+    // internal (private)
+    const char*             _name;
+    Metric                  _timeMetric;
+    Metric                  _bytesMetric;
+    bool                    _enabled;
+    std::int64_t            _startNs            = 0;
+    std::uint64_t           _startBytes         = 0;
+};
+
+//! Sample a metric into the process wide profiler, when it's enabled.
+export void profileSample(Metric metric, float value);
@@ -7,12 +7,26 @@ import sokol.app;
 import sokol.gfx;
 import sokol.gp;
 
+import main.framearena;
+import main.profile;
+
 namespace va = alx::va;
 namespace trig = alx::trig;
 using namespace trig::degree_literals;
 
 namespace {
 
+DrawCounters sDraws = {};   // of the render() in progress
+FrameArena sArena = {};     // the scratch of the draw helpers, reset by render()
+
+// sokol_gp uploads every vertex it draws, each frame.
+void countDraw(const size_t vertices)
+{
+    ++sDraws.drawCommands;
+    sDraws.vertices += static_cast<std::uint32_t>(vertices);
+    sDraws.uploadedVertices += static_cast<std::uint32_t>(vertices);
+}
+
 void setColor(const sg_color color)
 {
     sgp_set_color(color.r, color.g, color.b, color.a);
@@ -37,6 +51,7 @@ void drawSolidLine(const va::Vec2f start, const va::Vec2f end, const sg_color co
 {
     setColor(color);
     sgp_draw_line(start.x(), start.y(), end.x(), end.y());
+    countDraw(2);
 }
 
 [[maybe_unused]]
@@ -49,56 +64,62 @@ void drawDot(const va::Vec2f point, const sg_color color)
     line[1].b = cast(point + va::Vec2f{{0.f, 1.f}});
     setColor(color);
     sgp_draw_lines(line.data(), line.size());
+    countDraw(2 * line.size());
 }
 
 [[maybe_unused]]
 void drawCircle(const AppState& app, const va::Vec2f center, const float radius, const sg_color color, const int segments = 100)
 {
-    std::vector<sgp_line> vertices;
+    const std::span<sgp_line> vertices = sArena.allocate<sgp_line>(static_cast<size_t>(segments));
     const trig::RadF increment = trig::Full<trig::RadF> / segments;
     trig::RadF angle = {};
-    for (int i = 0; i < segments; ++i) {
+    for (sgp_line& vertex : vertices) {
         const va::Vec2f start {{center.x() + radius * cos(angle), center.y() + radius * sin(angle)}};
         angle += increment;
         const va::Vec2f end {{center.x() + radius * cos(angle), center.y() + radius * sin(angle)}};
         const va::Vec2f a = mapToScreen(app, start);
         const va::Vec2f b = mapToScreen(app, end);
-        vertices.push_back({cast(a), cast(b)});
+        vertex = {cast(a), cast(b)};
     }
     setColor(color);
     sgp_draw_lines(vertices.data(), static_cast<unsigned>(vertices.size()));
+    countDraw(2 * vertices.size());
 }
 
 [[maybe_unused]]
 void drawDisc(const AppState& app, const va::Vec2f center, const float radius, const sg_color color, const int segments = 100)
 {
-    std::vector<sgp_triangle> vertices;
+    const std::span<sgp_triangle> vertices = sArena.allocate<sgp_triangle>(static_cast<size_t>(segments));
     const trig::RadF increment = trig::Full<trig::RadF> / segments;
     trig::RadF angle = {};
-    for (int i = 0; i < segments; ++i) {
+    for (sgp_triangle& vertex : vertices) {
         const va::Vec2f start {{center.x() + radius * cos(angle), center.y() + radius * sin(angle)}};
         angle += increment;
         const va::Vec2f end {{center.x() + radius * cos(angle), center.y() + radius * sin(angle)}};
         const va::Vec2f a = mapToScreen(app, center);
         const va::Vec2f b = mapToScreen(app, start);
         const va::Vec2f c = mapToScreen(app, end);
-        vertices.push_back({cast(a), cast(b), cast(c)});
+        vertex = {cast(a), cast(b), cast(c)};
     }
     setColor(color);
     sgp_draw_filled_triangles(vertices.data(), static_cast<unsigned>(vertices.size()));
+    countDraw(3 * vertices.size());
     drawCircle(app, center, radius, color, segments);
 }
 
 void drawDottedLine(const va::Vec2f start, const va::Vec2f end, const sg_color color, const int segments = 101)
 {
-    std::vector<sgp_line> line;
+    // every other segment
+    const std::span<sgp_line> line = sArena.allocate<sgp_line>(static_cast<size_t>(segments + 1) / 2);
     va::Vec2f diff = end - start;
     va::Vec2f increment {{diff.x() / segments, diff.y() / segments}};
-    for (int i = 0; i < segments; i += 2) {
-        line.push_back({cast(start + increment * (i + 0.f)), cast(start + increment * (i + 1.f))});
+    for (size_t i = 0; i < line.size(); ++i) {
+        const float first = static_cast<float>(2 * i);
+        line[i] = {cast(start + increment * first), cast(start + increment * (first + 1.f))};
     }
     setColor(color);
     sgp_draw_lines(line.data(), static_cast<unsigned>(line.size()));
+    countDraw(2 * line.size());
 }
 
 [[maybe_unused]]
@@ -113,46 +134,51 @@ void drawSolidArrow(const va::Vec2f origin, const va::Vec2f vec, const sg_color
     arrow[2].b = cast(cast(arrow[2].a) - (vec.unit() * 20.f).rotated(-30_deg));
     setColor(color);
     sgp_draw_lines(arrow.data(), arrow.size());
+    countDraw(2 * arrow.size());
 };
 
 [[maybe_unused]]
 void drawDottedCircle(const AppState& app, const va::Vec2f center, const float radius, const sg_color color, const int segments = 100)
 {
-    std::vector<sgp_line> vertices;
+    // every other segment
+    const std::span<sgp_line> vertices = sArena.allocate<sgp_line>(static_cast<size_t>(segments + 1) / 2);
     //const float increment = 2 * kPi<float> / segments;
     const trig::RadF increment = trig::Full<trig::RadF> / segments;
     //float angle = 0.f;
     trig::RadF angle = {};
-    for (int i = 0; i < segments; i += 2) {
+    for (sgp_line& vertex : vertices) {
         const va::Vec2f start {{center.x() + radius * cos(angle), center.y() + radius * sin(angle)}};
         angle += increment;
         const va::Vec2f end {{center.x() + radius * cos(angle), center.y() + radius * sin(angle)}};
         angle += increment;
         const va::Vec2f a = mapToScreen(app, start);
         const va::Vec2f b = mapToScreen(app, end);
-        vertices.push_back({cast(a), cast(b)});
+        vertex = {cast(a), cast(b)};
     }
     setColor(color);
     sgp_draw_lines(vertices.data(), static_cast<unsigned>(vertices.size()));
+    countDraw(2 * vertices.size());
 }
 
 [[maybe_unused]]
 void drawDottedEllipse(const AppState& app, const va::Vec2f center, const float radius, const float xStretch, const sg_color color, const int segments = 100)
 {
-    std::vector<sgp_line> vertices;
+    // every other segment
+    const std::span<sgp_line> vertices = sArena.allocate<sgp_line>(static_cast<size_t>(segments + 1) / 2);
     const trig::RadF increment = trig::Full<trig::RadF> / segments;
     trig::RadF angle = {};
-    for (int i = 0; i < segments; i += 2) {
+    for (sgp_line& vertex : vertices) {
         const va::Vec2f start {{center.x() + radius * cos(angle) * xStretch, center.y() + radius * sin(angle)}};
         angle += increment;
         const va::Vec2f end = {{center.x() + radius * cos(angle) * xStretch, center.y() + radius * sin(angle)}};
         angle += increment;
         const va::Vec2f a = mapToScreen(app, start);
         const va::Vec2f b = mapToScreen(app, end);
-        vertices.push_back({cast(a), cast(b)});
+        vertex = {cast(a), cast(b)};
     }
     setColor(color);
     sgp_draw_lines(vertices.data(), static_cast<unsigned>(vertices.size()));
+    countDraw(2 * vertices.size());
 }
 
 [[maybe_unused]]
@@ -160,6 +186,7 @@ void drawFilledRectWithSize(const va::Vec2f origin, const va::Vec2f size, const
 {
     setColor(color);
     sgp_draw_filled_rect(origin.x(), origin.y(), size.x(), size.y());
+    countDraw(6);
 }
 
 [[maybe_unused]]
@@ -167,6 +194,7 @@ void drawFilledRectBetween(const va::Vec2f corner1, const va::Vec2f corner2, con
 {
     setColor(color);
     sgp_draw_filled_rect(corner1.x(), corner1.y(), corner2.x() - corner1.x(), corner2.y() - corner1.y());
+    countDraw(6);
 }
 
 void drawCheckpointEaseInterval(const AppState& app, const float time, const float progress, const float easeDuration, const float adjustedEaseDuration, const bool easeDurationBefore, const bool easeDurationAfter)
@@ -249,42 +277,6 @@ void drawCoordinates(const AppState& app)
     }
 }
 
-void drawProgress(const AppState& app, const Result& result)
-{
-    if (result.tessellatedProgress.empty()) {
-        return;
-    }
-    va::Vec2f prevPos = result.tessellatedProgress.front();
-    for (const va::Vec2f pos: result.tessellatedProgress) {
-        drawSolidLine(mapToScreen(app, prevPos), mapToScreen(app, pos), app._curveColor);
-        prevPos = pos;
-    }
-}
-
-void drawVelocity(const AppState& app, const Result& result)
-{
-    if (!app._showSpeed || result.tessellatedVelocity.empty()) {
-        return;
-    }
-    va::Vec2f prevPos = result.tessellatedVelocity.front();
-    for (const va::Vec2f pos: result.tessellatedVelocity) {
-        drawSolidLine(mapToScreen(app, prevPos), mapToScreen(app, pos), app._speedColor);
-        prevPos = pos;
-    }
-}
-
-void drawAccel(const AppState& app, const Result& result)
-{
-    if (!app._showAccel || result.tessellatedAccel.empty()) {
-        return;
-    }
-    va::Vec2f prevPos = result.tessellatedAccel.front();
-    for (const va::Vec2f pos: result.tessellatedAccel) {
-        drawSolidLine(mapToScreen(app, prevPos), mapToScreen(app, pos), app._accelColor);
-        prevPos = pos;
-    }
-}
-
 // void drawCircles(const AppState& app)
 // {
 //     if (!app._showCircles) {
@@ -387,26 +379,242 @@ void drawMouseCursor(const AppState& app)
     blackLines[1].b = cast(pos + va::Vec2f{{+0.f, +3.f}});
     setColor(sg_color {1.f, 1.f, 1.f, 1.f}); // white
     sgp_draw_lines(whiteLines.data(), whiteLines.size());
+    countDraw(2 * whiteLines.size());
     setColor(sg_color {0.f, 0.f, 0.f, 1.f}); // black
     sgp_draw_lines(blackLines.data(), blackLines.size());
+    countDraw(2 * blackLines.size());
     //sapp_show_mouse(false);
 }
 
+// Maps data coordinates to clip space the way mapToScreen() and sgp_project() do together, as
+// clip = data * transform.xy + transform.zw.
+std::array<float, 4> curveTransform(const AppState& app)
+{
+    const va::Vec2f windowSize {{sapp_widthf(), sapp_heightf()}};
+    const va::Vec2f origin = mapToScreen(app, {{0.f, 0.f}});
+    const va::Vec2f unit = mapToScreen(app, {{1.f, 1.f}}) - origin;
+    return {
+        2.f * unit.x() / windowSize.x(),
+        -2.f * unit.y() / windowSize.y(),
+        2.f * origin.x() / windowSize.x() - 1.f,
+        1.f - 2.f * origin.y() / windowSize.y(),
+    };
+}
+
+// The curve shader for each backend: positions through the transform uniform, one flat color.
+struct ShaderSource
+{
+    const char*             vertex;
+    const char*             fragment;
+};
+
+std::optional<ShaderSource> shaderSource(const sg_backend backend)
+{
+    switch (backend) {
+    case SG_BACKEND_GLCORE33:
+        return ShaderSource {
+            .vertex =
+                "#version 330\n"
+                "uniform vec4 transform;\n"
+                "layout(location = 0) in vec2 position;\n"
+                "void main() { gl_Position = vec4(position * transform.xy + transform.zw, 0.0, 1.0); }\n",
+            .fragment =
+                "#version 330\n"
+                "uniform vec4 color;\n"
+                "out vec4 fragColor;\n"
+                "void main() { fragColor = color; }\n",
+        };
+    case SG_BACKEND_METAL_MACOS:
+    case SG_BACKEND_METAL_IOS:
+    case SG_BACKEND_METAL_SIMULATOR:
+        return ShaderSource {
+            .vertex =
+                "#include <metal_stdlib>\n"
+                "using namespace metal;\n"
+                "struct params { float4 transform; };\n"
+                "struct vs_in { float2 position [[attribute(0)]]; };\n"
+                "vertex float4 _main(vs_in input [[stage_in]], constant params& p [[buffer(0)]]) {\n"
+                "    return float4(input.position * p.transform.xy + p.transform.zw, 0.0, 1.0);\n"
+                "}\n",
+            .fragment =
+                "#include <metal_stdlib>\n"
+                "using namespace metal;\n"
+                "struct params { float4 color; };\n"
+                "fragment float4 _main(constant params& p [[buffer(0)]]) { return p.color; }\n",
+        };
+    case SG_BACKEND_D3D11:
+        return ShaderSource {
+            .vertex =
+                "cbuffer params : register(b0) { float4 transform; };\n"
+                "float4 main(float2 position : POSITION) : SV_Position {\n"
+                "    return float4(position * transform.xy + transform.zw, 0.0, 1.0);\n"
+                "}\n",
+            .fragment =
+                "cbuffer params : register(b0) { float4 color; };\n"
+                "float4 main() : SV_Target0 { return color; }\n",
+        };
+    case SG_BACKEND_GLES3:
+        return ShaderSource {
+            .vertex =
+                "#version 300 es\n"
+                "uniform vec4 transform;\n"
+                "layout(location = 0) in vec2 position;\n"
+                "void main() { gl_Position = vec4(position * transform.xy + transform.zw, 0.0, 1.0); }\n",
+            .fragment =
+                "#version 300 es\n"
+                "precision mediump float;\n"
+                "uniform vec4 color;\n"
+                "out vec4 fragColor;\n"
+                "void main() { fragColor = color; }\n",
+        };
+    default:
+        // no shader written for it (WGPU, the dummy backend)
+        return std::nullopt;
+    }
+}
+
+// The vertex buffers take the tessellated points as they are.
+static_assert(sizeof(va::Vec2f) == 2 * sizeof(float));
+
 } // namespace
 
-void render(const AppState& app, const Result& result)
+DrawCounters render(const AppState& app)
 {
+    // the recording of the frame starts here, right after sgp_begin()
+    sArena.reset();
+    sDraws = {};
+    const std::uint64_t allocations = threadAllocationCount();
     sgp_set_blend_mode(SGP_BLENDMODE_BLEND);
     // Clear the frame buffer.
     setColor(app._windowBg);
     sgp_clear();
+    countDraw(6);
 
     drawCoordinates(app);
     drawPoly(app);
     //drawCircles(app);
-    drawProgress(app, result);
-    drawVelocity(app, result);
-    drawAccel(app, result);
 
+    sDraws.heapAllocations = static_cast<std::uint32_t>(threadAllocationCount() - allocations);
+    return sDraws;
+}
+
+DrawCounters renderOverlay(const AppState& app)
+{
+    sDraws = {};
+    const std::uint64_t allocations = threadAllocationCount();
+    sgp_set_blend_mode(SGP_BLENDMODE_BLEND);
     drawMouseCursor(app);
+    sDraws.heapAllocations = static_cast<std::uint32_t>(threadAllocationCount() - allocations);
+    return sDraws;
+}
+
+DrawCounters renderCurves(AppState& app, const Result& result)
+{
+    const std::array<sg_color, CurveRenderer::kCurveCount> colors = { app._curveColor, app._speedColor, app._accelColor };
+    const std::array<bool, CurveRenderer::kCurveCount> shown = { true, app._showSpeed, app._showAccel };
+    sg_apply_viewport(0, 0, sapp_width(), sapp_height(), true);
+    return app._curveRenderer.draw(result, curveTransform(app), colors, shown);
+}
+
+bool CurveRenderer::setup(std::string& error)
+{
+    const sg_backend backend = sg_query_backend();
+    const std::optional<ShaderSource> source = shaderSource(backend);
+    if (!source) {
+        error = std::format("no curve shader for the sokol_gfx backend {}", std::to_underlying(backend));
+        return false;
+    }
+    const sg_shader_desc shaderDesc = {
+        .attrs = {{ .name = "position", .sem_name = "POSITION" }},
+        .vs = {
+            .source = source->vertex,
+            .uniform_blocks = {{ .size = sizeof(float) * 4, .uniforms = {{ .name = "transform", .type = SG_UNIFORMTYPE_FLOAT4 }} }},
+        },
+        .fs = {
+            .source = source->fragment,
+            .uniform_blocks = {{ .size = sizeof(float) * 4, .uniforms = {{ .name = "color", .type = SG_UNIFORMTYPE_FLOAT4 }} }},
+        },
+        .label = "curve shader",
+    };
+    _shader = sg_make_shader(&shaderDesc);
+
+    sg_pipeline_desc pipelineDesc = {};
+    pipelineDesc.shader = _shader;
+    pipelineDesc.layout.attrs[0].format = SG_VERTEXFORMAT_FLOAT2;
+    pipelineDesc.colors[0].blend = {
+        .enabled            = true,
+        .src_factor_rgb     = SG_BLENDFACTOR_SRC_ALPHA,
+        .dst_factor_rgb     = SG_BLENDFACTOR_ONE_MINUS_SRC_ALPHA,
+        .src_factor_alpha   = SG_BLENDFACTOR_ONE,
+        .dst_factor_alpha   = SG_BLENDFACTOR_ONE_MINUS_SRC_ALPHA,
+    };
+    pipelineDesc.primitive_type = SG_PRIMITIVETYPE_LINE_STRIP;
+    pipelineDesc.label = "curve pipeline";
+    _pipeline = sg_make_pipeline(&pipelineDesc);
+    if (sg_query_pipeline_state(_pipeline) != SG_RESOURCESTATE_VALID) {
+        error = "the curve shader or pipeline failed to build";
+        return false;
+    }
+    return true;
+}
+
+void CurveRenderer::shutdown()
+{
+    for (Curve& curve : _curves) {
+        sg_destroy_buffer(curve.buffer);
+        curve = {};
+    }
+    sg_destroy_pipeline(_pipeline);
+    sg_destroy_shader(_shader);
+    _revision = 0;
+}
+
+DrawCounters CurveRenderer::draw(const Result& result, const std::span<const float, 4> transform, const std::span<const sg_color, kCurveCount> colors, const std::span<const bool, kCurveCount> shown)
+{
+    DrawCounters draws;
+    const std::array<const std::vector<va::Vec2f>*, kCurveCount> points = { &result.tessellatedProgress, &result.tessellatedVelocity, &result.tessellatedAccel };
+    if (result.revision != _revision) {
+        for (size_t index = 0; index < kCurveCount; ++index) {
+            Curve& curve = _curves[index];
+            const std::vector<va::Vec2f>& curvePoints = *points[index];
+            if (curvePoints.size() > curve.capacity) {
+                // grow by half again, so a curve that keeps growing a little doesn't reallocate each time
+                sg_destroy_buffer(curve.buffer);
+                curve.capacity = std::max(curvePoints.size(), curve.capacity + curve.capacity / 2);
+                const sg_buffer_desc bufferDesc = {
+                    .size   = curve.capacity * sizeof(va::Vec2f),
+                    .usage  = SG_USAGE_DYNAMIC,
+                    .label  = "curve vertices",
+                };
+                curve.buffer = sg_make_buffer(&bufferDesc);
+            }
+            if (!curvePoints.empty()) {
+                const sg_range data = { curvePoints.data(), curvePoints.size() * sizeof(va::Vec2f) };
+                sg_update_buffer(curve.buffer, &data);
+            }
+            curve.count = curvePoints.size();
+            draws.uploadedVertices += static_cast<std::uint32_t>(curve.count);
+        }
+        _revision = result.revision;
+    }
+
+    sg_apply_pipeline(_pipeline);
+    const sg_range transformData = { transform.data(), transform.size_bytes() };
+    sg_apply_uniforms(SG_SHADERSTAGE_VS, 0, &transformData);
+    for (size_t index = 0; index < kCurveCount; ++index) {
+        const Curve& curve = _curves[index];
+        if (!shown[index] || curve.count < 2) {
+            continue;
+        }
+        sg_bindings bindings = {};
+        bindings.vertex_buffers[0] = curve.buffer;
+        sg_apply_bindings(&bindings);
+        const std::array<float, 4> color = { colors[index].r, colors[index].g, colors[index].b, colors[index].a };
+        const sg_range colorData = { color.data(), sizeof(color) };
+        sg_apply_uniforms(SG_SHADERSTAGE_FS, 0, &colorData);
+        sg_draw(0, static_cast<int>(curve.count), 1);
+        ++draws.drawCommands;
+        draws.vertices += static_cast<std::uint32_t>(curve.count);
+    }
+    return draws;
 }
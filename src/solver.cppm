@@ -0,0 +1,202 @@
+module;
+
+export module main.solver;
+
+import std;
+
+import alx.va;
+
+import main.workerpool;
+
+namespace va = alx::va;
+
+// Runtime selection of the easing between two velocities. The evaluation and tessellation code is
+// specialized at compile time for each of them.
+export enum class EaseInOut
+{
+    Linear,
+    Sine,
+};
+export constexpr size_t kEaseInOutCount = 2;
+
+export struct Checkpoint
+{
+    float time                 = 0;
+    float progress             = 0;
+    float easeDuration         = 0;
+    float adjustedEaseDuration = 0; // calculated
+};
+
+// The phases of a solved path, split at every ease boundary. Segment i eases from velocities[i] to
+// velocities[i + 1] between times[i] and times[i + 1]; constant velocity segments have the same
+// velocity at both ends. progress holds the cumulative progress at each breakpoint.
+export struct SegmentTable
+{
+    std::vector<float>      times               = {};
+    std::vector<float>      progress            = {};
+    std::vector<float>      velocities          = {};
+};
+
+export struct Result
+{
+    EaseInOut               easeInOut           = EaseInOut::Sine;
+    std::vector<float>      velocities          = {};
+    SegmentTable            segments            = {};   // built from the velocities before evaluating, see buildSegments()
+    std::vector<va::Vec2f>  tessellatedVelocity = {};
+    std::vector<va::Vec2f>  tessellatedProgress = {};
+    std::vector<va::Vec2f>  tessellatedAccel    = {};
+    // first progress, velocity and accel point of each segment, to re-tessellate a few in place
+    std::vector<std::array<size_t, 3>> tessellatedRuns = {};
+    std::uint64_t           revision            = 0;    // changes with the tessellated curves, for caches of them
+    double                  totalErrorAbs       = 0.;
+};
+
+// The tridiagonal velocity system of the last direct solve, with both of its eliminations, so that a
+// change to a few ease durations only has to re-solve the rows they touch. Row k reads
+//
+//     lower[k] * v[k-1] + diag[k] * v[k] + upper[k] * v[k+1] = rhs[k]
+//
+// The forward elimination expresses v[k] = forwardRhs[k] - forwardUpper[k] * v[k+1] from the rows
+// up to k, the backward one v[k] = backwardRhs[k] - backwardLower[k] * v[k-1] from the rows from k.
+export struct VelocitySystem
+{
+    std::vector<double>     lower               = {};
+    std::vector<double>     diag                = {};
+    std::vector<double>     upper               = {};
+    std::vector<double>     rhs                 = {};
+    std::vector<double>     forwardUpper        = {};
+    std::vector<double>     forwardRhs          = {};
+    std::vector<double>     backwardLower       = {};
+    std::vector<double>     backwardRhs         = {};
+    std::vector<double>     solution            = {};
+    size_t                  forwardValid        = 0;    // forward rows [0, forwardValid) are current
+    size_t                  backwardValid       = 0;    // backward rows [backwardValid, size) are current
+};
+
+// The steps of a solve, stored compactly: one velocity vector and one error per step. Tessellating
+// a step is left to selectStep(), unless the full results are retained.
+export struct SolveHistory
+{
+    EaseInOut               easeInOut           = EaseInOut::Sine;
+    size_t                  stride              = 0;    // velocities per step
+    std::vector<float>      velocities          = {};   // the velocities of all steps, back to back
+    std::vector<double>     errors              = {};   // totalErrorAbs of each step
+    std::vector<Result>     retained            = {};   // full results of each step, when retained
+    Result                  selected            = {};   // the tessellated selected step
+    int                     selectedStep        = -1;
+    VelocitySystem          system              = {};   // kept by the direct solver
+
+    [[nodiscard]] int stepCount() const { return static_cast<int>(errors.size()); }
+};
+
+export enum class SolverMode
+{
+    Direct,     // solve the banded (tridiagonal) velocity system in one step
+    Iterative,  // seed and refine the largest error checkpoint until the error settles
+};
+
+export struct Path
+{
+    float                   startTime                   = 0;
+    float                   startProgress               = 0;
+    float                   startVelocity               = 0;
+    float                   startEaseDuration           = 0;
+    float                   endTime                     = 0;
+    float                   endProgress                 = 0;
+    float                   endVelocity                 = 0;
+    float                   endEaseDuration             = 0;
+    std::vector<Checkpoint> checkpoints                 = {};
+    float                   adjustedStartEaseDuration   = 0;    // calculated
+    float                   adjustedEndEaseDuration     = 0;    // calculated
+};
+
+// Everything a solve reads. The app copies it out of its state, so the variants can be solved on
+// other threads while the path keeps being edited.
+export struct SolveInput
+{
+    Path                    path                        = {};
+    SolverMode              solverMode                  = SolverMode::Direct;
+    float                   tessellationTolerance       = 0;    // in progress units
+    bool                    retainFullResults           = false;
+};
+
+// Settings shared by all the paths of a solveBatch().
+export struct BatchSettings
+{
+    EaseInOut               easeInOut                   = EaseInOut::Sine;
+    SolverMode              solverMode                  = SolverMode::Direct;
+    bool                    adjustEase                  = true;     // run adjustEaseDurationsP() on each path first
+    bool                    tessellate                  = false;
+    float                   tessellationTolerance       = 0;        // fraction of the progress span of each path
+    size_t                  progressSamples             = 0;        // evenly spaced from start to end time, inclusive
+};
+
+// The buffers one worker of solveBatch() reuses from path to path.
+struct BatchScratch
+{
+    std::vector<float>      easings         = {};   // for adjustEaseDurationsP()
+    Result                  result          = {};
+    VelocitySystem          system          = {};
+    std::vector<float>      times           = {};   // of the progress samples
+    std::vector<float>      velocity        = {};   // evaluated along with the progress samples
+    std::vector<float>      accel           = {};
+};
+
+// The outcome of a solveBatch(), one entry per path in input order. Reusing it across batches reuses
+// its buffers, the workers' scratch included.
+export struct BatchSolution
+{
+    std::vector<float>      velocities                  = {};   // the final velocities of all paths, back to back
+    std::vector<size_t>     offsets                     = {};   // where each path's velocities start, plus the end
+    std::vector<double>     errors                      = {};   // totalErrorAbs of each path
+    std::vector<int>        steps                       = {};   // solver steps of each path, the seed included
+    std::vector<Result>     tessellated                 = {};   // of each path, when tessellating
+    std::vector<float>      progress                    = {};   // progressSamples of each path, back to back
+
+    [[nodiscard]] std::span<const float> pathVelocities(const size_t index) const
+    {
+        return std::span(velocities).subspan(offsets[index], offsets[index + 1] - offsets[index]);
+    }
+    [[nodiscard]] std::span<const float> pathProgress(const size_t index, const size_t samples) const
+    {
+        return std::span(progress).subspan(index * samples, samples);
+    }
+
+    // internal (private)
+    std::vector<size_t>         order                   = {};   // the paths, largest first
+    std::vector<BatchScratch>   scratch                 = {};   // one per worker, plus one for the calling thread
+};
+
+export void solve(const SolveInput& input, EaseInOut easeInOut, SolveHistory& history);
+// Re-solves a directly solved history after alignEaseDurations() changed the eases in [firstEase,
+// lastEase], with -1 for the start ease and checkpoints.size() for the end ease. Only the rows of
+// those eases are re-eliminated, the velocities are updated outwards until the change dies out and
+// only the segments that moved are re-tessellated. Falls back to solve() when nothing is cached.
+export void solveIncremental(const SolveInput& input, SolveHistory& history, int firstEase, int lastEase);
+export const Result& selectStep(const SolveInput& input, SolveHistory& history, int step);
+// Solves independent paths on the pool, largest first, adjusting their eases in place first when the
+// settings ask for it. The workers steal from each other, so a few long paths don't keep the short
+// ones waiting, and each reuses its own scratch buffers from path to path, kept in the solution from
+// batch to batch, so past the first few paths solving allocates nothing beyond the tessellations.
+export void solveBatch(std::span<Path> paths, const BatchSettings& settings, WorkerPool& pool, BatchSolution& solution);
+// Builds result.segments from result.velocities, one per checkpoint plus the end, for a result that
+// wasn't solved, like velocities loaded from a path file. The evaluation functions need it.
+export void buildSegments(const Path& path, Result& result);
+// Evaluates progress, velocity and acceleration for monotonically increasing times in a single sweep
+// over the segments of the result. All spans must have the same size.
+export void evaluateBatch(const Path& path, const Result& result, std::span<const float> times, std::span<float> progress, std::span<float> velocity, std::span<float> accel);
+// Same as evaluateBatch, vectorized over blocks of samples. The sine easing uses polynomial sin/cos
+// approximations there, so each eased value differs from the scalar reference by at most
+// kLaneEaseMaxError times the velocity change (and duration, for progress) of its segment.
+export constexpr float kLaneEaseMaxError = 4e-7f;
+export void evaluateBatchLanes(const Path& path, const Result& result, std::span<const float> times, std::span<float> progress, std::span<float> velocity, std::span<float> accel);
+// Returns the range of eases it changed, in the index convention of modifiedIndex.
+export std::pair<int, int> alignEaseDurations(Path& path, const int modifiedIndex);
+export void adjustEaseDurationsP(Path& path);
+// Same, with the buffer of its intermediate easings supplied by the caller.
+export void adjustEaseDurationsP(Path& path, std::vector<float>& newEasings);
+export void adjustEaseDurations1(Path& path);
+export void adjustEaseDurations2(Path& path);
+
+// Progress at a single time, for point queries. Prefer evaluateBatch() for many increasing times.
+export float progressAt(const Path& path, const Result& result, const float time);
@@ -0,0 +1,155 @@
+module main.appstate;
+
+import std;
+
+import main.profile;
+
+namespace {
+
+// Trace names of the variant solves, indexed by EaseInOut.
+constexpr std::array<const char*, kEaseInOutCount> kVariantScopes = { "solve linear", "solve sine" };
+
+float tessellationTolerance(const AppState& app)
+{
+    // the tolerance is relative to the progress span, which the plot maps to the viewport height
+    return app._tessellationTolerance * std::max(std::abs(app._path.endProgress - app._path.startProgress), std::numeric_limits<float>::min());
+}
+
+} // namespace
+
+SolveInput solveInput(const AppState& app)
+{
+    return {
+        .path                   = app._path,
+        .solverMode             = app._solverMode,
+        .tessellationTolerance  = tessellationTolerance(app),
+        .retainFullResults      = app._retainFullResults,
+    };
+}
+
+void launchSolve(AppState& app, const bool adjustEase)
+{
+    if (adjustEase) {
+        adjustEaseDurationsP(app._path);
+    }
+    app._solver.post({ .input = solveInput(app) });
+    // the last step, whatever the solve ends up with
+    app._selectedResult = std::numeric_limits<int>::max();
+}
+
+void launchSolveIncremental(AppState& app, const int firstEase, const int lastEase)
+{
+    app._solver.post({ .input = solveInput(app), .incremental = true, .firstEase = firstEase, .lastEase = lastEase });
+    app._selectedResult = std::numeric_limits<int>::max();
+}
+
+void launchSelectStep(AppState& app, const int step)
+{
+    app._solver.post({ .solve = false, .step = step });
+    app._selectedResult = step;
+}
+
+void SolverThread::post(SolveRequest request)
+{
+    {
+        const std::lock_guard lock(_mutex);
+        if (!request.solve && _pending) {
+            // the waiting request tessellates the step instead of its own
+            _pending->step = request.step;
+            request = std::move(*_pending);
+        } else if (_pending && _pending->solve && request.incremental) {
+            // the skipped request changed eases of its own, so re-solve both ranges, or everything
+            if (_pending->incremental) {
+                request.firstEase = std::min(request.firstEase, _pending->firstEase);
+                request.lastEase = std::max(request.lastEase, _pending->lastEase);
+            } else {
+                request.incremental = false;
+            }
+        }
+        _pending = std::move(request);
+    }
+#if defined(__EMSCRIPTEN__)
+    // no threads to hand it to, solve right away
+    SolveRequest pending = std::move(*_pending);
+    _pending.reset();
+    solveRequest(pending);
+#else
+    if (!_thread.joinable()) {
+        _thread = std::jthread([this](const std::stop_token stop) { run(stop); });
+    }
+    _wakeup.notify_one();
+#endif
+}
+
+void SolverThread::run(const std::stop_token stop)
+{
+    while (true) {
+        SolveRequest request;
+        {
+            std::unique_lock lock(_mutex);
+            if (!_wakeup.wait(lock, stop, [this] { return _pending.has_value(); })) {
+                return;
+            }
+            request = std::move(*_pending);
+            _pending.reset();
+        }
+        solveRequest(request);
+    }
+}
+
+void SolverThread::solveRequest(SolveRequest& request)
+{
+    if (request.solve) {
+        _input = std::move(request.input);
+    }
+    _step = request.step;
+    // the variants solve side by side, so a request takes as long as the slower one, tessellation aside
+    const std::int64_t startNs = profileNow();
+    std::array<std::int64_t, kEaseInOutCount> solvedNs = {};
+    std::array<std::future<void>, kEaseInOutCount> solves;
+    for (size_t variant = 0; variant < kEaseInOutCount; ++variant) {
+        solves[variant] = _pool.submit([this, &request, &solvedNs, variant] {
+            const auto easeInOut = static_cast<EaseInOut>(variant);
+            // the bytes of the solve and of its tessellation
+            const ProfileScope scope(kVariantScopes[variant], Metric::None, Metric::BytesAllocated);
+            SolveHistory& history = _histories[variant];
+            if (request.solve && request.incremental && history.easeInOut == easeInOut) {
+                solveIncremental(_input, history, request.firstEase, request.lastEase);
+            } else if (request.solve) {
+                solve(_input, easeInOut, history);
+            }
+            solvedNs[variant] = profileNow();
+            // tessellate the selected step here rather than on the UI thread
+            if (history.stepCount() > 0) {
+                selectStep(_input, history, _step);
+            }
+        });
+    }
+    for (std::future<void>& result : solves) {
+        result.get();
+    }
+    if (request.solve) {
+        profileSample(Metric::SolveTime, static_cast<float>(std::ranges::max(solvedNs) - startNs) / 1000.0f);
+    }
+    publish();
+}
+
+void SolverThread::publish()
+{
+    // assigned into the back buffer's own vectors, which keep their capacity from publish to publish
+    SolvedPath& published = _published.back();
+    published.input = _input;
+    for (size_t variant = 0; variant < kEaseInOutCount; ++variant) {
+        SolveHistory& history = _histories[variant];
+        SolvedVariant& solved = published.results[variant];
+        solved.errors = history.errors;
+        if (history.stepCount() > 0) {
+            solved.selected = selectStep(_input, history, _step);
+            solved.selectedStep = std::clamp(_step, 0, history.stepCount() - 1);
+        } else {
+            solved.selected = {};
+            solved.selectedStep = -1;
+        }
+    }
+    _published.publish();
+}
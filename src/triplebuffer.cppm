@@ -0,0 +1,37 @@
+module;
+
+export module main.triplebuffer;
+
+import std;
+
+// Hands values from one writer thread to one reader thread without locks. The writer fills its own
+// slot and swaps it with the spare one, the reader swaps its own slot with the spare one when that
+// holds something newer. Neither side ever waits for the other, and the reader always gets the
+// latest published value; the ones it missed are simply overwritten.
+export template <typename T>
+struct TripleBuffer
+{
+    //! The slot the writer fills before publishing it.
+    [[nodiscard]] T& back() { return _slots[_back]; }
+
+    //! Make the back slot the latest value and take the spare one as the next back slot.
+    void publish() { _back = static_cast<std::uint8_t>(_spare.exchange(static_cast<std::uint8_t>(_back | kFresh), std::memory_order_acq_rel) & kIndex); }
+
+    //! The latest published value. It belongs to the reader until the next call.
+    [[nodiscard]] T& front()
+    {
+        if (_spare.load(std::memory_order_relaxed) & kFresh) {
+            _front = static_cast<std::uint8_t>(_spare.exchange(_front, std::memory_order_acq_rel) & kIndex);
+        }
+        return _slots[_front];
+    }
+
+    // internal (private)
+    static constexpr std::uint8_t kIndex = 0x3;
+    static constexpr std::uint8_t kFresh = 0x4;   // set while the spare slot holds an unread value
+
+    std::array<T, 3>                _slots  = {};
+    std::uint8_t                    _back   = 0;
+    std::uint8_t                    _front  = 1;
+    std::atomic<std::uint8_t>       _spare  = 2;
+};
@@ -0,0 +1,141 @@
+module;
+
+export module main.workerpool;
+
+import std;
+
+// A fixed set of threads, each with its own task queue. Tasks posted from outside the pool are dealt
+// round-robin, tasks posted from a worker go to its own queue. A worker runs its own tasks oldest
+// first and, once it runs dry, steals the newest task of another worker, so a long task doesn't hold
+// up the short ones queued behind it. Without threads (a single core, or a platform without them)
+// tasks run inline when posted.
+export struct WorkerPool
+{
+    WorkerPool() : WorkerPool(defaultThreadCount()) {}
+    explicit WorkerPool(const size_t threadCount)
+        : _queues(threadCount)
+    {
+        _threads.reserve(threadCount);
+        for (size_t index = 0; index < threadCount; ++index) {
+            _threads.emplace_back([this, index](const std::stop_token stop) { run(index, stop); });
+        }
+    }
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    //! Queue a task without a way to wait for it.
+    void post(std::function<void()> task)
+    {
+        if (_threads.empty()) {
+            task();
+            return;
+        }
+        size_t worker = currentWorker();
+        if (worker == _threads.size()) {
+            worker = _nextQueue.fetch_add(1, std::memory_order_relaxed) % _queues.size();
+        }
+        {
+            // counted under the queue lock, like take() uncounts, so the count never drops below zero
+            Queue& queue = _queues[worker];
+            const std::lock_guard lock(queue.mutex);
+            _queued.fetch_add(1, std::memory_order_release);
+            queue.tasks.push_back(std::move(task));
+        }
+        {
+            // a worker checks _queued under this lock before sleeping, so it can't miss the wakeup
+            const std::lock_guard lock(_sleepMutex);
+        }
+        _wakeup.notify_one();
+    }
+
+    //! Queue a task and get a future for its result.
+    template <typename Task>
+    std::future<std::invoke_result_t<Task>> submit(Task&& task)
+    {
+        auto packaged = std::make_shared<std::packaged_task<std::invoke_result_t<Task>()>>(std::forward<Task>(task));
+        auto future = packaged->get_future();
+        post([packaged] { (*packaged)(); });
+        return future;
+    }
+
+    [[nodiscard]] size_t threadCount() const { return _threads.size(); }
+
+    //! Index of the worker the caller runs on, threadCount() when it isn't one of this pool's.
+    [[nodiscard]] size_t currentWorker() const
+    {
+        const Identity& identity = currentIdentity();
+        return identity.pool == this ? identity.worker : _threads.size();
+    }
+
+    [[nodiscard]] static size_t defaultThreadCount()
+    {
+#if defined(__EMSCRIPTEN__)
+        return 0;
+#else
+        const size_t cores = std::thread::hardware_concurrency();
+        return cores > 1 ? cores : 0;
+#endif
+    }
+
+    // internal (private)
+    struct Queue
+    {
+        std::mutex                          mutex   = {};
+        std::deque<std::function<void()>>   tasks   = {};
+    };
+    struct Identity
+    {
+        const WorkerPool*   pool    = nullptr;
+        size_t              worker  = 0;
+    };
+
+    static Identity& currentIdentity()
+    {
+        thread_local Identity identity;
+        return identity;
+    }
+
+    std::optional<std::function<void()>> take(const size_t worker)
+    {
+        for (size_t offset = 0; offset < _queues.size(); ++offset) {
+            Queue& queue = _queues[(worker + offset) % _queues.size()];
+            const std::lock_guard lock(queue.mutex);
+            if (queue.tasks.empty()) {
+                continue;
+            }
+            std::optional<std::function<void()>> task;
+            if (offset == 0) {
+                task = std::move(queue.tasks.front());
+                queue.tasks.pop_front();
+            } else {
+                task = std::move(queue.tasks.back());
+                queue.tasks.pop_back();
+            }
+            _queued.fetch_sub(1, std::memory_order_relaxed);
+            return task;
+        }
+        return std::nullopt;
+    }
+
+    void run(const size_t worker, const std::stop_token stop)
+    {
+        currentIdentity() = { .pool = this, .worker = worker };
+        while (true) {
+            if (std::optional<std::function<void()>> task = take(worker)) {
+                (*task)();
+                continue;
+            }
+            std::unique_lock lock(_sleepMutex);
+            if (!_wakeup.wait(lock, stop, [this] { return _queued.load(std::memory_order_acquire) > 0; })) {
+                return;
+            }
+        }
+    }
+
+    std::vector<Queue>                  _queues     = {};
+    std::atomic<size_t>                 _queued     = 0;    // tasks in all the queues together
+    std::atomic<size_t>                 _nextQueue  = 0;    // round-robin for tasks from outside
+    std::mutex                          _sleepMutex = {};
+    std::condition_variable_any         _wakeup     = {};
+    std::vector<std::jthread>           _threads    = {};   // last, so they are joined before the queues go
+};